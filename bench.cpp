@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include "workloads.hpp"
+#include "policies.hpp"
+#include "find_page.hpp"
+
+using std::vector;
+using std::string;
+
+#define BENCH_SEED 350
+#define BENCH_PAGES 16384
+#define DEFAULT_REPS 5
+// Odd, so multiplying by it scatters page ids over 64 bits without collisions
+#define SCATTER_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+typedef uint32_t PageId;
+
+// Runs an engine straight on a trace of 64-bit ids, with no universe
+typedef uint64_t (*SparseRun)(const vector<uint64_t>&, unsigned int);
+
+// A policy under test: either run once per memory size, or a stack algorithm
+// computing the hits of every memory size up to memsize in one pass. Engines
+// also run on sparse ids, which they find by the SIMD scan or the hash index.
+struct BenchPolicy {
+	const char* name;
+	DensePolicy run;
+	DenseHitCurve curve;
+	SparseRun sparse;
+};
+
+struct BenchWorkload {
+	const char* name;
+	Workload<PageId> generate;
+};
+
+// Mean, sample standard deviation and minimum of the timed repetitions
+struct Timing {
+	double mean;
+	double stddev;
+	double min;
+};
+
+static Timing summarize(const vector<double>& samples){
+	Timing timing = {0, 0, samples[0]};
+	for(double sample : samples){
+		timing.mean += sample;
+		if(sample < timing.min) timing.min = sample;
+	}
+	timing.mean /= samples.size();
+	if(samples.size() > 1){
+		for(double sample : samples){
+			timing.stddev += (sample - timing.mean) * (sample - timing.mean);
+		}
+		timing.stddev = sqrt(timing.stddev / (samples.size() - 1));
+	}
+	return timing;
+}
+
+// Run the policy once, returning its hits at memsize
+static int run_policy(const BenchPolicy& policy, const DenseWorkload& trace, unsigned int memsize){
+	if(policy.curve) return policy.curve(trace, memsize)[memsize];
+	return policy.run(trace, memsize);
+}
+
+template <template <typename> class Engine>
+static uint64_t run_sparse(const vector<uint64_t>& trace, unsigned int memsize){
+	Engine<uint64_t> policy(memsize);
+	return policy.access_batch(trace.data(), trace.size(), NULL);
+}
+
+static uint64_t run_sparse_rand(const vector<uint64_t>& trace, unsigned int memsize){
+	RandPolicy<uint64_t> policy(memsize, RAND_DEFAULT_SEED);
+	return policy.access_batch(trace.data(), trace.size(), NULL);
+}
+
+static uint64_t run_sparse_opt(const vector<uint64_t>& trace, unsigned int memsize){
+	OptPolicy<uint64_t> policy(memsize);
+	for(uint64_t page : trace) policy.lookahead(page);
+	return policy.access_batch(trace.data(), trace.size(), NULL);
+}
+
+// Warm up once, then time reps runs of run(), keeping the hits of the last
+template <typename Run>
+static Timing time_runs(Run run, int reps, size_t length, uint64_t& hits){
+	hits = run();
+	vector<double> samples;
+	for(int rep = 0; rep < reps; rep++){
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		hits = run();
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		samples.push_back(elapsed.count() / length);
+	}
+	return summarize(samples);
+}
+
+static void usage(const char* name){
+	fprintf(stderr, "usage: %s [--reps N] [--quick] [--out FILE]\n", name);
+	fprintf(stderr, "  --reps N    timed repetitions of every run (default %d)\n", DEFAULT_REPS);
+	fprintf(stderr, "  --quick     only the shortest trace, for a fast smoke run\n");
+	fprintf(stderr, "  --out FILE  write the JSON report to FILE instead of stdout\n");
+}
+
+/*\brief Times every policy on fixed-seed workloads and reports JSON
+ *
+ * Each (policy, workload, trace length, memory size) run is executed once to
+ * warm up, then timed over several repetitions. The report gives ns/access
+ * (mean, standard deviation and minimum) and accesses/sec per run, along with
+ * the hit count so that speedups can be told apart from behaviour changes.
+ * Every engine is also timed on the same accesses scattered over 64-bit ids,
+ * with memory sizes on both sides of SlotIndex::SCAN_CAPACITY, so that the
+ * scan and hash indexes behind find_page_kernel are measured too.
+ */
+int main(int argc, char** argv){
+	int reps = DEFAULT_REPS;
+	bool quick = false;
+	const char* out_path = NULL;
+	for(int i = 1; i < argc; i++){
+		if(!strcmp(argv[i], "--reps") && i + 1 < argc) reps = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--quick")) quick = true;
+		else if(!strcmp(argv[i], "--out") && i + 1 < argc) out_path = argv[++i];
+		else{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if(reps < 1){
+		usage(argv[0]);
+		return 1;
+	}
+
+	vector<BenchPolicy> policies({
+		{"OPT", PRP_OPT, NULL, run_sparse_opt},
+		{"LRU", PRP_LRU, NULL, run_sparse<LruPolicy>},
+		{"FIFO", PRP_FIFO, NULL, run_sparse<FifoPolicy>},
+		{"RAND", PRP_RAND, NULL, run_sparse_rand},
+		{"CLOCK", PRP_CLOCK, NULL, run_sparse<ClockPolicy>},
+		{"ARC", PRP_ARC, NULL, run_sparse<ArcPolicy>},
+		{"CAR", PRP_CAR, NULL, run_sparse<CarPolicy>},
+		{"CLOCK-Pro", PRP_CLOCK_PRO, NULL, run_sparse<ClockProPolicy>},
+		{"LIRS", PRP_LIRS, NULL, run_sparse<LirsPolicy>},
+		{"W-TinyLFU", PRP_WTINYLFU, NULL, run_sparse<WTinyLfuPolicy>},
+		{"OPT_curve", NULL, OPT_hit_curve, NULL},
+		{"LRU_curve", NULL, LRU_hit_curve, NULL}});
+	vector<BenchWorkload> workloads({{"nonlocal", workload_nonlocal<PageId>}, {"80-20", workload_80_20<PageId>}, {"looping", workload_looping<PageId>}, {"zipf", workload_zipf<PageId>}});
+	vector<size_t> lengths({100000, 1000000});
+	if(quick) lengths.resize(1);
+	vector<unsigned int> memsizes({16, 128, 1024});
+	const unsigned int scan_capacity = SlotIndex<uint64_t>::SCAN_CAPACITY;
+	vector<unsigned int> sparse_memsizes({scan_capacity / 2, scan_capacity * 8});
+
+	FILE* out = out_path ? fopen(out_path, "w") : stdout;
+	if(!out){
+		perror(out_path);
+		return 1;
+	}
+	fprintf(out, "{\n  \"find_page_kernel\": \"%s\",\n  \"seed\": %d,\n  \"num_pages\": %d,\n  \"repetitions\": %d,\n  \"results\": [", find_page_kernel(), BENCH_SEED, BENCH_PAGES, reps);
+
+	bool first = true;
+	for(const BenchWorkload& workload : workloads){
+		for(size_t length : lengths){
+			vector<PageId> pages(length);
+			workload.generate(pages, BENCH_PAGES, BENCH_SEED);
+			// Made dense once, outside the timed runs
+			DenseWorkload trace(pages);
+			vector<uint64_t> sparse(pages.begin(), pages.end());
+			for(uint64_t& page : sparse) page *= SCATTER_MULTIPLIER;
+			for(const BenchPolicy& policy : policies){
+				for(int ids = 0; ids < 2; ids++){
+					if(ids == 1 && !policy.sparse) continue;
+					for(unsigned int memsize : ids == 0 ? memsizes : sparse_memsizes){
+						uint64_t hits;
+						Timing timing = ids == 0
+							? time_runs([&](){ return (uint64_t)run_policy(policy, trace, memsize); }, reps, length, hits)
+							: time_runs([&](){ return policy.sparse(sparse, memsize); }, reps, length, hits);
+						const char* kind = ids == 0 ? "dense" : "sparse";
+						fprintf(stderr, "%-9s %-8s %-6s %8zu %5u  %8.2f ns/access\n", policy.name, workload.name, kind, length, memsize, timing.mean);
+						fprintf(out, "%s\n    {\"policy\": \"%s\", \"workload\": \"%s\", \"ids\": \"%s\", \"length\": %zu, \"memsize\": %u, \"hits\": %llu, "
+							"\"ns_per_access\": {\"mean\": %.3f, \"stddev\": %.3f, \"min\": %.3f}, \"accesses_per_sec\": %.0f}",
+							first ? "" : ",", policy.name, workload.name, kind, length, memsize, (unsigned long long)hits,
+							timing.mean, timing.stddev, timing.min, 1e9 / timing.mean);
+						first = false;
+					}
+				}
+			}
+		}
+	}
+	fprintf(out, "\n  ]\n}\n");
+	if(out != stdout) fclose(out);
+	return 0;
+}
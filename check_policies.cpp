@@ -0,0 +1,1381 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <set>
+#include <cmath>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "workloads.hpp"
+#include "policies.hpp"
+#include "find_page.hpp"
+#include "rng.hpp"
+#include "scheduler.hpp"
+#include "trace_cache.hpp"
+#include "trace_file.hpp"
+
+using std::vector;
+using std::string;
+using std::list;
+using std::unordered_map;
+
+#define CHECK_PAGES 300
+#define CHECK_LENGTH 20000
+// Brute-force OPT rescans the rest of the trace on every miss
+#define OPT_CHECK_LENGTH 3000
+#define CURVE_MAX_MEMSIZE 200
+// Odd, so multiplying by it scatters page ids over 64 bits without collisions
+#define SCATTER_MULTIPLIER 0x9E3779B97F4A7C15ULL
+// Mismatches printed in detail per check, the rest are only counted
+#define MAX_REPORTED 5
+// Tasks per round of the TaskPool check, every SLOW_TASK-th of them sleeping
+#define POOL_TASKS 4000
+#define SLOW_TASK 64
+// Zipf samples drawn per skew, and the chi-square bound their counts must
+// meet over ZIPF_PAGES pages: the 0.999 quantile for ZIPF_PAGES - 1 degrees
+// of freedom, so a correct sampler fails about once in a thousand seeds
+#define ZIPF_SAMPLES 1000000
+#define ZIPF_PAGES 100
+#define ZIPF_CHI_SQUARE_BOUND 148.2
+// The converter under test, built beside this program by make check
+#define TRACECONV "./traceconv"
+
+struct CheckWorkload {
+	string name;
+	vector<uint32_t> pages;
+};
+
+/*\brief Workloads every check runs on
+ *
+ * The four generators with two seeds each, one of them with a one-off scan
+ * through fresh pages so that ghost hits of the adaptive policies are reached,
+ * and short random traces over few pages for the corner cases.
+ */
+static vector<CheckWorkload> check_workloads(size_t length){
+	vector<CheckWorkload> workloads;
+	const char* names[] = {"nonlocal", "80-20", "looping", "zipf"};
+	Workload<uint32_t> generators[] = {workload_nonlocal<uint32_t>, workload_80_20<uint32_t>, workload_looping<uint32_t>, workload_zipf<uint32_t>};
+	for(int g = 0; g < 4; g++){
+		for(uint64_t seed = 1; seed <= 2; seed++){
+			CheckWorkload workload = {string(names[g]) + "/" + std::to_string(seed), vector<uint32_t>(length)};
+			generators[g](workload.pages, CHECK_PAGES, seed);
+			workloads.push_back(workload);
+		}
+	}
+	CheckWorkload scan = workloads[6];
+	scan.name = "zipf+scan";
+	for(size_t i = length / 2; i < length / 2 + length / 10; i++){
+		scan.pages[i] = CHECK_PAGES + 1 + i;
+	}
+	workloads.push_back(scan);
+	Xoshiro256 random(3);
+	for(int t = 0; t < 8; t++){
+		CheckWorkload small = {"random/" + std::to_string(t), vector<uint32_t>(random.below(1500))};
+		const uint32_t pages = 1 + random.below(100);
+		for(uint32_t& page : small.pages){
+			page = random.below(4) == 0 ? random.below(pages) : random.below(pages / 4 + 1);
+		}
+		workloads.push_back(small);
+	}
+	return workloads;
+}
+
+static const unsigned int MEMSIZES[] = {0, 1, 2, 3, 7, 16, 50, 100, 128, 129, 200, 400};
+
+// The FIFO of the original program: a circular array scanned on every access
+static int ref_fifo(const vector<uint32_t>& workload, unsigned int memsize){
+	if(memsize == 0) return 0;
+	vector<int64_t> frames(memsize, -1);
+	unsigned int head = 0;
+	int hits = 0;
+	for(uint32_t access : workload){
+		if(std::count(frames.begin(), frames.end(), access) > 0){
+			hits++;
+		} else {
+			frames[head] = access;
+			head = (head + 1) % memsize;
+		}
+	}
+	return hits;
+}
+
+// The LRU of the original program: the oldest last use is found by a linear scan
+static int ref_lru(const vector<uint32_t>& workload, unsigned int memsize){
+	unordered_map<uint32_t, size_t> cache;
+	int hits = 0;
+	for(size_t time = 0; time < workload.size(); time++){
+		uint32_t access = workload[time];
+		if(cache.count(access)){
+			hits++;
+			cache[access] = time;
+			continue;
+		}
+		cache[access] = time;
+		if(cache.size() > memsize){
+			auto oldest = cache.begin();
+			for(auto entry = cache.begin(); entry != cache.end(); entry++){
+				if(entry->second < oldest->second) oldest = entry;
+			}
+			cache.erase(oldest);
+		}
+	}
+	return hits;
+}
+
+// Belady's MIN by brute force: on a miss, evict the page used furthest ahead
+static int ref_opt(const vector<uint32_t>& workload, unsigned int memsize){
+	vector<uint32_t> frames;
+	int hits = 0;
+	for(size_t time = 0; time < workload.size(); time++){
+		uint32_t access = workload[time];
+		if(std::find(frames.begin(), frames.end(), access) != frames.end()){
+			hits++;
+		} else if(frames.size() < memsize){
+			frames.push_back(access);
+		} else if(memsize > 0){
+			size_t victim = 0, furthest = 0;
+			for(size_t f = 0; f < frames.size(); f++){
+				size_t next = time + 1;
+				while(next < workload.size() && workload[next] != frames[f]) next++;
+				if(next > furthest){
+					furthest = next;
+					victim = f;
+				}
+			}
+			frames[victim] = access;
+		}
+	}
+	return hits;
+}
+
+/*\brief ARC as given in Fig. 4 of Megiddo and Modha, FAST 2003
+ *
+ * T1, T2, B1 and B2 are lists with the most recent page at the front.
+ */
+class RefArc {
+public:
+	explicit RefArc(unsigned int c) : c(c), p(0), hits(0) {}
+
+	int run(const vector<uint32_t>& workload){
+		for(uint32_t page : workload) access(page);
+		return hits;
+	}
+
+private:
+	enum { T1, T2, B1, B2 };
+
+	void move(uint32_t page, int to){
+		std::pair<int, list<uint32_t>::iterator>& where = index[page];
+		lists[where.first].erase(where.second);
+		lists[to].push_front(page);
+		where = std::make_pair(to, lists[to].begin());
+	}
+
+	void dropLru(int from){
+		index.erase(lists[from].back());
+		lists[from].pop_back();
+	}
+
+	void replace(bool inB2){
+		if(!lists[T1].empty() && (lists[T1].size() > p || (inB2 && lists[T1].size() == p))){
+			move(lists[T1].back(), B1);
+		} else {
+			move(lists[T2].back(), B2);
+		}
+	}
+
+	void access(uint32_t page){
+		auto found = index.find(page);
+		if(found != index.end()){
+			const int list = found->second.first;
+			if(list == T1 || list == T2){
+				hits++;
+			} else if(list == B1){
+				p = std::min<size_t>(c, p + std::max<size_t>(lists[B2].size() / lists[B1].size(), 1));
+				replace(false);
+			} else {
+				p -= std::min<size_t>(p, std::max<size_t>(lists[B1].size() / lists[B2].size(), 1));
+				replace(true);
+			}
+			move(page, T2);
+			return;
+		}
+		if(c == 0) return;
+		if(lists[T1].size() + lists[B1].size() == c){
+			if(lists[T1].size() < c){
+				dropLru(B1);
+				replace(false);
+			} else {
+				dropLru(T1);
+			}
+		} else {
+			const size_t total = lists[T1].size() + lists[T2].size() + lists[B1].size() + lists[B2].size();
+			if(total >= c){
+				if(total == 2 * c) dropLru(B2);
+				replace(false);
+			}
+		}
+		lists[T1].push_front(page);
+		index[page] = std::make_pair(T1, lists[T1].begin());
+	}
+
+	size_t c, p;
+	int hits;
+	list<uint32_t> lists[4];
+	unordered_map<uint32_t, std::pair<int, list<uint32_t>::iterator>> index;
+};
+
+/*\brief CAR as given in Fig. 2 of Bansal and Modha, FAST 2004
+ *
+ * The clocks T1 and T2 have their hand at the front and their tail at the
+ * back, the history lists B1 and B2 their most recent page at the front.
+ */
+class RefCar {
+public:
+	explicit RefCar(unsigned int c) : c(c), p(0), hits(0) {}
+
+	int run(const vector<uint32_t>& workload){
+		for(uint32_t page : workload) access(page);
+		return hits;
+	}
+
+private:
+	enum { T1, T2, B1, B2 };
+
+	void replace(){
+		for(;;){
+			const int clock = lists[T1].size() >= std::max<size_t>(1, p) ? T1 : T2;
+			const uint32_t page = lists[clock].front();
+			lists[clock].pop_front();
+			if(!referenced[page]){
+				const int history = clock == T1 ? B1 : B2;
+				lists[history].push_front(page);
+				where[page] = history;
+				return;
+			}
+			referenced[page] = false;
+			lists[T2].push_back(page);
+			where[page] = T2;
+		}
+	}
+
+	void dropLru(int from){
+		where.erase(lists[from].back());
+		lists[from].pop_back();
+	}
+
+	void access(uint32_t page){
+		auto found = where.find(page);
+		if(found != where.end() && (found->second == T1 || found->second == T2)){
+			referenced[page] = true;
+			hits++;
+			return;
+		}
+		if(c == 0) return;
+		const bool ghost = found != where.end();
+		if(lists[T1].size() + lists[T2].size() == c){
+			replace();
+			if(!ghost && lists[T1].size() + lists[B1].size() == c){
+				dropLru(B1);
+			} else if(!ghost && lists[T1].size() + lists[T2].size() + lists[B1].size() + lists[B2].size() == 2 * c){
+				dropLru(B2);
+			}
+		}
+		referenced[page] = false;
+		if(!ghost){
+			lists[T1].push_back(page);
+			where[page] = T1;
+			return;
+		}
+		if(where[page] == B1){
+			p = std::min<size_t>(c, p + std::max<size_t>(1, lists[B2].size() / lists[B1].size()));
+		} else {
+			p -= std::min<size_t>(p, std::max<size_t>(1, lists[B1].size() / lists[B2].size()));
+		}
+		lists[where[page]].remove(page);
+		lists[T2].push_back(page);
+		where[page] = T2;
+	}
+
+	size_t c, p;
+	int hits;
+	list<uint32_t> lists[4];
+	unordered_map<uint32_t, int> where;
+	unordered_map<uint32_t, bool> referenced;
+};
+
+/*\brief LIRS as given by Jiang and Zhang, SIGMETRICS 2002
+ *
+ * With the parameters of LirsPolicy: 1% of the frames (at least one) hold
+ * resident HIR pages, and at most c non-resident HIR pages are remembered,
+ * the oldest being forgotten first. The stack S has its top at the front,
+ * the queue Q its next victim at the front.
+ */
+class RefLirs {
+public:
+	explicit RefLirs(unsigned int c) : c(c), lirCapacity(c - std::min(c, std::max(c / 100, 1u))), lirs(0), hits(0) {}
+
+	int run(const vector<uint32_t>& workload){
+		for(uint32_t page : workload) access(page);
+		return hits;
+	}
+
+private:
+	enum Status { LIR, HIR, NON_RESIDENT };
+
+	bool inStack(uint32_t page) const {
+		return std::find(stack.begin(), stack.end(), page) != stack.end();
+	}
+
+	// Pop HIR pages off the bottom of the stack until a LIR page is there
+	void prune(){
+		while(!stack.empty() && status[stack.back()] != LIR){
+			const uint32_t bottom = stack.back();
+			stack.pop_back();
+			if(status[bottom] == NON_RESIDENT){
+				ghosts.remove(bottom);
+				status.erase(bottom);
+			}
+		}
+	}
+
+	// Make page LIR at the top of the stack, demoting the bottom LIR page if there are too many
+	void promote(uint32_t page){
+		stack.push_front(page);
+		if(lirCapacity == 0){
+			status[page] = HIR;
+			queue.push_back(page);
+			return;
+		}
+		status[page] = LIR;
+		if(++lirs > lirCapacity){
+			const uint32_t bottom = stack.back();
+			stack.pop_back();
+			status[bottom] = HIR;
+			lirs--;
+			queue.push_back(bottom);
+			prune();
+		}
+	}
+
+	// Free the frame of the resident HIR page at the front of the queue
+	void evict(){
+		const uint32_t victim = queue.front();
+		queue.pop_front();
+		if(!inStack(victim)){
+			status.erase(victim);
+			return;
+		}
+		status[victim] = NON_RESIDENT;
+		ghosts.push_back(victim);
+		if(ghosts.size() > c){
+			const uint32_t oldest = ghosts.front();
+			ghosts.pop_front();
+			stack.remove(oldest);
+			status.erase(oldest);
+		}
+	}
+
+	void access(uint32_t page){
+		auto found = status.find(page);
+		if(found != status.end() && found->second == LIR){
+			hits++;
+			const bool bottom = stack.back() == page;
+			stack.remove(page);
+			stack.push_front(page);
+			if(bottom) prune();
+			return;
+		}
+		if(found != status.end() && found->second == HIR){
+			hits++;
+			queue.remove(page);
+			if(inStack(page)){
+				stack.remove(page);
+				promote(page);
+			} else {
+				stack.push_front(page);
+				queue.push_back(page);
+			}
+			return;
+		}
+		if(found != status.end()){
+			// Non-resident HIR page still on the stack
+			ghosts.remove(page);
+			stack.remove(page);
+			if(lirs + queue.size() == c) evict();
+			promote(page);
+			return;
+		}
+		if(c == 0) return;
+		if(lirs < lirCapacity){
+			status[page] = LIR;
+			lirs++;
+			stack.push_front(page);
+			return;
+		}
+		if(lirs + queue.size() == c) evict();
+		status[page] = HIR;
+		stack.push_front(page);
+		queue.push_back(page);
+	}
+
+	unsigned int c, lirCapacity, lirs;
+	int hits;
+	list<uint32_t> stack, queue, ghosts;
+	unordered_map<uint32_t, Status> status;
+};
+
+// CLOCK-Pro as the paper draws it: every page on one circle, and each hand
+// stepping over the pages one at a time, skipping those it does not act on
+class RefClockPro {
+public:
+	explicit RefClockPro(unsigned int m) : m(m), coldTarget(std::max(m / 100, 1u)), hot(0), cold(0), nonResident(0), hits(0) {
+		handHot = handCold = handTest = circle.end();
+	}
+
+	int run(const vector<uint32_t>& workload){
+		for(uint32_t page : workload) access(page);
+		return hits;
+	}
+
+private:
+	enum Status { HOT, COLD, NON_RESIDENT };
+	struct Page {
+		uint32_t page;
+		Status status;
+		bool ref, test;
+	};
+	typedef list<Page>::iterator Hand;
+
+	Hand following(Hand it){
+		++it;
+		return it == circle.end() ? circle.begin() : it;
+	}
+
+	// First cold page from from on, resident only if asked, other than skip
+	Hand seek(Hand from, Hand skip, bool resident){
+		Hand it = from;
+		do {
+			if(it != skip && it->status != HOT && (!resident || it->status == COLD)) return it;
+			it = following(it);
+		} while(it != from);
+		return circle.end();
+	}
+
+	// Move the hands off a page about to leave its place on the circle
+	void leave(Hand it){
+		if(handHot == it) handHot = circle.size() == 1 ? circle.end() : following(it);
+		if(handCold == it) handCold = seek(following(it), it, true);
+		if(handTest == it) handTest = seek(following(it), it, false);
+	}
+
+	// A hand with no page to act on waits for the first one to appear
+	void settle(Hand it){
+		if(handCold == circle.end() && it->status == COLD) handCold = it;
+		if(handTest == circle.end() && it->status != HOT) handTest = it;
+	}
+
+	// The head of the circle is just behind the hot hand
+	void insertHead(const Page& page){
+		Hand it = circle.insert(handHot, page);
+		if(handHot == circle.end()) handHot = it;
+		where[page.page] = it;
+		settle(it);
+	}
+
+	void endTest(Page& page){
+		if(!page.test) return;
+		page.test = false;
+		if(!page.ref && coldTarget > 1) coldTarget--;
+	}
+
+	void erase(Hand it){
+		leave(it);
+		where.erase(it->page);
+		circle.erase(it);
+	}
+
+	void removeNonResident(Hand it){
+		erase(it);
+		nonResident--;
+		if(coldTarget > 1) coldTarget--;
+	}
+
+	void runHandHot(){
+		for(;;){
+			Hand it = handHot;
+			if(it->status == NON_RESIDENT){
+				removeNonResident(it);
+				continue;
+			}
+			handHot = following(it);
+			if(it->status == COLD) endTest(*it);
+			else if(it->ref) it->ref = false;
+			else {
+				it->status = COLD;
+				it->test = false;
+				hot--;
+				cold++;
+				settle(it);
+				return;
+			}
+		}
+	}
+
+	void runHandTest(){
+		for(;;){
+			Hand it = handTest;
+			if(it->status == NON_RESIDENT){
+				removeNonResident(it);
+				return;
+			}
+			endTest(*it);
+			handTest = seek(following(it), it, false);
+		}
+	}
+
+	void runHandCold(){
+		Hand it = handCold;
+		Page page = *it;
+		if(page.ref){
+			page.ref = false;
+			leave(it);
+			circle.erase(it);
+			if(page.test){
+				coldTarget = std::min(coldTarget + 1, m);
+				page.status = HOT;
+				cold--;
+				hot++;
+			}
+			page.test = true;
+			insertHead(page);
+			return;
+		}
+		if(!page.test){
+			erase(it);
+			cold--;
+			return;
+		}
+		handCold = seek(following(it), it, true);
+		it->status = NON_RESIDENT;
+		cold--;
+		if(++nonResident > m) runHandTest();
+	}
+
+	void balance(){
+		while(hot > m - coldTarget) runHandHot();
+	}
+
+	void freeFrame(){
+		while(hot + cold >= m){
+			balance();
+			runHandCold();
+		}
+	}
+
+	void access(uint32_t page){
+		auto found = where.find(page);
+		if(found != where.end() && found->second->status != NON_RESIDENT){
+			found->second->ref = true;
+			hits++;
+			return;
+		}
+		if(m == 0) return;
+		if(found != where.end()){
+			// Missed during its test period
+			coldTarget = std::min(coldTarget + 1, m);
+			erase(found->second);
+			nonResident--;
+			freeFrame();
+			insertHead({page, HOT, false, false});
+			hot++;
+			balance();
+			return;
+		}
+		const bool filling = hot + cold < m;
+		freeFrame();
+		const Status status = filling && hot < m - coldTarget ? HOT : COLD;
+		insertHead({page, status, false, true});
+		if(status == HOT) hot++;
+		else cold++;
+	}
+
+	unsigned int m, coldTarget, hot, cold, nonResident;
+	int hits;
+	list<Page> circle;
+	Hand handHot, handCold, handTest;
+	unordered_map<uint32_t, Hand> where;
+};
+
+static int ref_arc(const vector<uint32_t>& workload, unsigned int memsize){ return RefArc(memsize).run(workload); }
+static int ref_car(const vector<uint32_t>& workload, unsigned int memsize){ return RefCar(memsize).run(workload); }
+static int ref_lirs(const vector<uint32_t>& workload, unsigned int memsize){ return RefLirs(memsize).run(workload); }
+static int ref_clock_pro(const vector<uint32_t>& workload, unsigned int memsize){ return RefClockPro(memsize).run(workload); }
+
+static int failures = 0;
+
+// Count a mismatch, printing the first few of a check
+static void mismatch(int& count, const char* check, const string& workload, unsigned int memsize, long expected, long got){
+	if(count++ < MAX_REPORTED){
+		fprintf(stderr, "  %s on %s with memsize %u: expected %ld hits, got %ld\n", check, workload.c_str(), memsize, expected, got);
+	}
+}
+
+static void report(const char* check, int mismatches, int runs){
+	printf("%-36s %s (%d runs)\n", check, mismatches ? "FAILED" : "ok", runs);
+	if(mismatches) failures++;
+}
+
+// Count a run of a check, and a mismatch unless it went as expected
+static void expect(int& mismatches, int& runs, const char* check, bool ok, const string& what){
+	runs++;
+	if(!ok && mismatches++ < MAX_REPORTED){
+		fprintf(stderr, "  %s: %s\n", check, what.c_str());
+	}
+}
+
+// A wrapper against its reference on every workload and memory size
+static void check_reference(const char* check, PageReplacementPolicy<uint32_t> policy, PageReplacementPolicy<uint32_t> reference, const vector<CheckWorkload>& workloads){
+	int mismatches = 0, runs = 0;
+	for(const CheckWorkload& workload : workloads){
+		for(unsigned int memsize : MEMSIZES){
+			const int expected = reference(workload.pages, memsize);
+			const int got = policy(workload.pages, memsize);
+			if(got != expected) mismatch(mismatches, check, workload.name, memsize, expected, got);
+			runs++;
+		}
+	}
+	report(check, mismatches, runs);
+}
+
+// A hit curve against a run per memory size
+static void check_curve(const char* check, HitCurvePolicy<uint32_t> curve, PageReplacementPolicy<uint32_t> policy, const vector<CheckWorkload>& workloads){
+	int mismatches = 0, runs = 0;
+	for(const CheckWorkload& workload : workloads){
+		const vector<int> hits = curve(workload.pages, CURVE_MAX_MEMSIZE);
+		for(unsigned int memsize = 0; memsize <= CURVE_MAX_MEMSIZE; memsize++){
+			const int expected = policy(workload.pages, memsize);
+			if(hits[memsize] != expected) mismatch(mismatches, check, workload.name, memsize, expected, hits[memsize]);
+			runs++;
+		}
+	}
+	report(check, mismatches, runs);
+}
+
+// Runs an engine over a trace, with a flat table when universe is set and
+// otherwise the SIMD scan or the hash index, as the memory size selects
+template <typename PageId>
+using EngineRun = uint64_t (*)(const vector<PageId>&, unsigned int memsize, unsigned int universe);
+
+template <template <typename> class Engine, typename PageId>
+static uint64_t run_engine(const vector<PageId>& trace, unsigned int memsize, unsigned int universe){
+	Engine<PageId> policy(memsize, universe);
+	return policy.access_batch(trace.data(), trace.size(), NULL);
+}
+
+template <typename PageId>
+static uint64_t run_rand(const vector<PageId>& trace, unsigned int memsize, unsigned int universe){
+	RandPolicy<PageId> policy(memsize, RAND_DEFAULT_SEED, universe);
+	return policy.access_batch(trace.data(), trace.size(), NULL);
+}
+
+template <typename PageId>
+static uint64_t run_opt(const vector<PageId>& trace, unsigned int memsize, unsigned int universe){
+	OptPolicy<PageId> policy(memsize, universe);
+	for(PageId page : trace) policy.lookahead(page);
+	return policy.access_batch(trace.data(), trace.size(), NULL);
+}
+
+/*\brief An engine gives the same hits whichever index finds its pages
+ *
+ * The dense run on 32-bit ids with a universe is compared to 64-bit runs with
+ * no universe, on the same ids and, unless the engine hashes the ids
+ * themselves, on ids scattered over 64 bits. The memory sizes straddle
+ * SlotIndex::SCAN_CAPACITY, so both the scan and the hash index are covered.
+ */
+static void check_index_modes(const char* check, EngineRun<uint32_t> run32, EngineRun<uint64_t> run64, bool scatter, const vector<CheckWorkload>& workloads){
+	int mismatches = 0, runs = 0;
+	for(const CheckWorkload& workload : workloads){
+		const unsigned int universe = workload.pages.empty() ? 1 : *std::max_element(workload.pages.begin(), workload.pages.end()) + 1;
+		vector<uint64_t> wide(workload.pages.begin(), workload.pages.end());
+		vector<uint64_t> scattered(wide);
+		for(uint64_t& page : scattered) page *= SCATTER_MULTIPLIER;
+		for(unsigned int memsize : MEMSIZES){
+			const long expected = run32(workload.pages, memsize, universe);
+			const long same = run64(wide, memsize, 0);
+			if(same != expected) mismatch(mismatches, check, workload.name, memsize, expected, same);
+			if(scatter){
+				const long sparse = run64(scattered, memsize, 0);
+				if(sparse != expected) mismatch(mismatches, check, workload.name + " scattered", memsize, expected, sparse);
+			}
+			runs++;
+		}
+	}
+	report(check, mismatches, runs);
+}
+
+#define ENGINE_RUNS(Engine) run_engine<Engine, uint32_t>, run_engine<Engine, uint64_t>
+
+/*\brief RAND is reproducible from its seed
+ *
+ * Every cache of PRP_RAND_seeds gives the hits of PRP_RAND_seeded with its
+ * seed, PRP_RAND is the default seed, and an engine replays exactly the same
+ * hits and misses when built again or reset. Different seeds must give
+ * different results somewhere, or the seed is not being used.
+ */
+static void check_rand_seeds(const vector<CheckWorkload>& workloads){
+	const char* check = "RAND seeds reproduce";
+	const vector<uint64_t> seeds = {1, 2, RAND_DEFAULT_SEED, 0xFFFFFFFFFFFFFFFFULL};
+	int mismatches = 0, runs = 0;
+	bool seeds_differ = false;
+	for(const CheckWorkload& workload : workloads){
+		for(unsigned int memsize : MEMSIZES){
+			const string where = workload.name + " with memsize " + std::to_string(memsize);
+			const vector<int> hits = PRP_RAND_seeds(workload.pages, memsize, seeds);
+			for(size_t s = 0; s < seeds.size(); s++){
+				expect(mismatches, runs, check, hits[s] == PRP_RAND_seeded(workload.pages, memsize, seeds[s]),
+					"PRP_RAND_seeds differs from PRP_RAND_seeded for seed " + std::to_string(seeds[s]) + " on " + where);
+			}
+			expect(mismatches, runs, check, PRP_RAND(workload.pages, memsize) == PRP_RAND_seeded(workload.pages, memsize, RAND_DEFAULT_SEED),
+				"PRP_RAND is not the default seed on " + where);
+			seeds_differ = seeds_differ || hits[0] != hits[1];
+
+			RandPolicy<uint32_t> first(memsize, seeds[0]), second(memsize, seeds[0]);
+			vector<uint8_t> first_hits(workload.pages.size()), second_hits(workload.pages.size()), reset_hits(workload.pages.size());
+			first.access_batch(workload.pages.data(), workload.pages.size(), first_hits.data());
+			second.access_batch(workload.pages.data(), workload.pages.size(), second_hits.data());
+			first.reset();
+			first.access_batch(workload.pages.data(), workload.pages.size(), reset_hits.data());
+			expect(mismatches, runs, check, first_hits == second_hits, "two engines with one seed differ on " + where);
+			expect(mismatches, runs, check, first_hits == reset_hits, "a reset engine differs on " + where);
+		}
+	}
+	expect(mismatches, runs, check, seeds_differ, "seeds 1 and 2 give the same hits on every workload");
+	report(check, mismatches, runs);
+}
+
+/*\brief TaskPool runs every task exactly once
+ *
+ * Rounds of tasks with a few slow ones among them, so that workers run dry
+ * and steal, on pools of several sizes; wait() must return only once all
+ * tasks of the round are done, and destroying a pool must finish the tasks
+ * still queued.
+ */
+static void check_task_pool(){
+	const char* check = "TaskPool runs every task once";
+	int mismatches = 0, runs = 0;
+	for(unsigned int threads : {1u, 2u, 4u, 0u}){
+		vector<std::atomic<int>> ran(POOL_TASKS);
+		std::mutex lock;
+		std::set<std::thread::id> workers;
+		{
+			TaskPool pool(threads);
+			const string where = "with " + std::to_string(pool.size()) + " threads";
+			for(int round = 1; round <= 3; round++){
+				for(int t = 0; t < POOL_TASKS; t++){
+					pool.submit([&ran, &lock, &workers, t](){
+						if(t % SLOW_TASK == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+						ran[t]++;
+						std::lock_guard<std::mutex> guard(lock);
+						workers.insert(std::this_thread::get_id());
+					});
+				}
+				pool.wait();
+				int wrong = 0;
+				for(const std::atomic<int>& count : ran) wrong += count != round;
+				expect(mismatches, runs, check, wrong == 0, std::to_string(wrong) + " tasks not run exactly once by wait() in round " + std::to_string(round) + " " + where);
+			}
+			expect(mismatches, runs, check, pool.size() == 1 || workers.size() > 1, "only one worker ran tasks " + where);
+			// Left queued for the destructor
+			for(int t = 0; t < POOL_TASKS; t++){
+				pool.submit([&ran, t](){ ran[t]++; });
+			}
+		}
+		int wrong = 0;
+		for(const std::atomic<int>& count : ran) wrong += count != 4;
+		expect(mismatches, runs, check, wrong == 0, std::to_string(wrong) + " tasks not run when the pool of " + std::to_string(threads) + " threads was destroyed");
+	}
+	report(check, mismatches, runs);
+}
+
+/*\brief A stream gives the accesses of its vector generator
+ *
+ * Whatever the chunk size it is drained with, and stays exhausted after.
+ * Replaying the stream through simulate_stream gives the hits of the vector.
+ */
+template <typename PageId, typename MakeStream>
+static void compare_stream(int& mismatches, int& runs, const char* check, const string& name, const vector<PageId>& expected, MakeStream make){
+	for(size_t chunk : {(size_t)1, (size_t)7, (size_t)4096, expected.size() + 1}){
+		auto stream = make();
+		vector<PageId> got, buffer(chunk);
+		size_t n;
+		while((n = stream.next(buffer.data(), chunk)) > 0){
+			got.insert(got.end(), buffer.begin(), buffer.begin() + n);
+		}
+		expect(mismatches, runs, check, got == expected, name + " in chunks of " + std::to_string(chunk) + " differs from its vector generator");
+		expect(mismatches, runs, check, stream.next(buffer.data(), chunk) == 0, name + " produced more after it was exhausted");
+	}
+	auto stream = make();
+	LruPolicy<PageId> streamed(50), batched(50);
+	expect(mismatches, runs, check, simulate_stream(stream, streamed) == batched.access_batch(expected.data(), expected.size(), NULL),
+		name + " simulates to other hits than its vector");
+}
+
+template <typename PageId>
+static void check_streams_of(int& mismatches, int& runs, const char* check, const string& width){
+	const uint64_t length = 30000;
+	for(uint64_t num_pages : {(uint64_t)1, (uint64_t)CHECK_PAGES, (uint64_t)1 << 30}){
+		for(uint64_t seed = 1; seed <= 2; seed++){
+			const string suffix = "/" + std::to_string(num_pages) + "/" + std::to_string(seed) + " " + width;
+			vector<PageId> workload(length);
+			workload_nonlocal(workload, num_pages, seed);
+			compare_stream(mismatches, runs, check, "nonlocal" + suffix, workload, [&](){ return NonlocalStream<PageId>(length, num_pages, seed); });
+			workload_80_20(workload, num_pages, seed);
+			compare_stream(mismatches, runs, check, "80-20" + suffix, workload, [&](){ return EightyTwentyStream<PageId>(length, num_pages, seed); });
+			workload_looping(workload, num_pages, seed);
+			compare_stream(mismatches, runs, check, "looping" + suffix, workload, [&](){ return LoopingStream<PageId>(length, num_pages, seed); });
+			workload_zipf(workload, num_pages, seed);
+			compare_stream(mismatches, runs, check, "zipf" + suffix, workload, [&](){ return ZipfStream<PageId>(length, num_pages, ZIPF_DEFAULT_SKEW, seed); });
+			workload_zipf_skewed(workload, num_pages, 0.6, seed);
+			compare_stream(mismatches, runs, check, "zipf 0.6" + suffix, workload, [&](){ return ZipfStream<PageId>(length, num_pages, 0.6, seed); });
+		}
+	}
+}
+
+static void check_streams(){
+	const char* check = "Streams match vector generators";
+	int mismatches = 0, runs = 0;
+	check_streams_of<uint32_t>(mismatches, runs, check, "32-bit");
+	check_streams_of<uint64_t>(mismatches, runs, check, "64-bit");
+	report(check, mismatches, runs);
+}
+
+/*\brief The Zipf sampler draws page k with probability proportional to 1/(k+1)^skew
+ *
+ * A chi-square test of the page counts against the exact distribution over
+ * a small page space, for several skews. Over a huge page space the samples
+ * must stay in range.
+ */
+static void check_zipf(){
+	const char* check = "Zipf samples follow the distribution";
+	int mismatches = 0, runs = 0;
+	for(double skew : {0.0, 0.6, ZIPF_DEFAULT_SKEW, 1.5, 3.0}){
+		ZipfStream<uint32_t> stream(ZIPF_SAMPLES, ZIPF_PAGES, skew, 11);
+		vector<uint64_t> counts(ZIPF_PAGES);
+		bool in_range = true;
+		for(int i = 0; i < ZIPF_SAMPLES; i++){
+			const uint32_t page = stream.sample();
+			if(page < ZIPF_PAGES) counts[page]++;
+			else in_range = false;
+		}
+		double total = 0;
+		for(int k = 0; k < ZIPF_PAGES; k++) total += std::pow(k + 1.0, -skew);
+		double chi_square = 0;
+		for(int k = 0; k < ZIPF_PAGES; k++){
+			const double expected = ZIPF_SAMPLES * std::pow(k + 1.0, -skew) / total;
+			chi_square += (counts[k] - expected) * (counts[k] - expected) / expected;
+		}
+		const string where = "skew " + std::to_string(skew);
+		expect(mismatches, runs, check, in_range, "a page out of range with " + where);
+		expect(mismatches, runs, check, chi_square < ZIPF_CHI_SQUARE_BOUND, "chi-square " + std::to_string(chi_square) + " with " + where);
+
+		const uint64_t huge = (uint64_t)1 << 40;
+		ZipfStream<uint64_t> wide(ZIPF_SAMPLES, huge, skew, 11);
+		bool wide_in_range = true;
+		for(int i = 0; i < ZIPF_SAMPLES / 10; i++){
+			wide_in_range = wide_in_range && wide.sample() < huge;
+		}
+		expect(mismatches, runs, check, wide_in_range, "a page out of range over 2^40 pages with " + where);
+	}
+	report(check, mismatches, runs);
+}
+
+// A workload generator that counts how often the cache falls back on it
+static int generated = 0;
+
+static void counted_looping(vector<uint32_t>& workload, uint64_t num_pages, uint64_t seed){
+	generated++;
+	workload_looping(workload, num_pages, seed);
+}
+
+static bool file_exists(const string& path){
+	return access(path.c_str(), F_OK) == 0;
+}
+
+// A fresh directory for the files of a check, empty if none could be made
+static string scratch_directory(){
+	char directory[] = "/tmp/check_policies.XXXXXX";
+	if(!mkdtemp(directory)){
+		perror("mkdtemp");
+		return string();
+	}
+	return directory;
+}
+
+/*\brief TraceCache generates each trace once and reloads it by versioned key
+ *
+ * In memory and in a scratch directory: a trace is generated on first use
+ * only, shared by concurrent callers, saved under a name carrying
+ * WORKLOAD_VERSION and loaded back by a later cache. Files under another
+ * name or of the wrong length are never used.
+ */
+static void check_trace_cache(){
+	const char* check = "TraceCache keys and reloads traces";
+	int mismatches = 0, runs = 0;
+	const size_t length = 5000;
+	vector<uint32_t> expected(length);
+	workload_looping(expected, CHECK_PAGES, 7);
+
+	{
+		TraceCache cache;
+		generated = 0;
+		const vector<uint32_t>* shared[16];
+		{
+			TaskPool pool(4);
+			for(const vector<uint32_t>*& trace : shared){
+				pool.submit([&cache, &trace, length](){ trace = &cache.get("looping", counted_looping, length, CHECK_PAGES, 7); });
+			}
+		}
+		expect(mismatches, runs, check, generated == 1, std::to_string(generated) + " generations for one trace got concurrently");
+		expect(mismatches, runs, check, std::count(shared, shared + 16, shared[0]) == 16, "concurrent callers got different copies of a trace");
+		expect(mismatches, runs, check, *shared[0] == expected, "a cached trace differs from the generator");
+		cache.get("looping", counted_looping, length, CHECK_PAGES, 8);
+		expect(mismatches, runs, check, generated == 2, "another seed was not generated separately");
+	}
+
+	const string directory = scratch_directory();
+	if(directory.empty()){
+		expect(mismatches, runs, check, false, "no scratch directory");
+		report(check, mismatches, runs);
+		return;
+	}
+	const string prefix = directory + "/looping-";
+	const string path = prefix + "v" + std::to_string(WORKLOAD_VERSION) + "-" + std::to_string(length) + "-" + std::to_string(CHECK_PAGES) + "-7.trace";
+	const string unversioned = prefix + std::to_string(length) + "-" + std::to_string(CHECK_PAGES) + "-7.trace";
+	// A trace saved by a build without versioned keys, with other accesses
+	TraceWriter writer;
+	vector<uint32_t> stale(length, 1);
+	expect(mismatches, runs, check, writer.open(unversioned) && writer.write(stale.data(), stale.size()) && writer.close(), "could not write " + unversioned);
+
+	generated = 0;
+	expect(mismatches, runs, check, TraceCache(directory).get("looping", counted_looping, length, CHECK_PAGES, 7) == expected, "a trace next to a stale file differs from the generator");
+	expect(mismatches, runs, check, generated == 1, "the unversioned file was loaded");
+	expect(mismatches, runs, check, file_exists(path), "no trace saved as " + path);
+	expect(mismatches, runs, check, TraceCache(directory).get("looping", counted_looping, length, CHECK_PAGES, 7) == expected, "a reloaded trace differs from the generator");
+	expect(mismatches, runs, check, generated == 1, "a saved trace was generated again");
+
+	// A file of the wrong length under the key is replaced
+	expect(mismatches, runs, check, writer.open(path) && writer.write(stale.data(), length / 2) && writer.close(), "could not write " + path);
+	expect(mismatches, runs, check, TraceCache(directory).get("looping", counted_looping, length, CHECK_PAGES, 7) == expected, "a short file was loaded");
+	expect(mismatches, runs, check, generated == 2, "a short file was not generated again");
+
+	unlink(path.c_str());
+	unlink(unversioned.c_str());
+	expect(mismatches, runs, check, rmdir(directory.c_str()) == 0, "files left in " + directory);
+	report(check, mismatches, runs);
+}
+
+// Offset of patch_file that appends instead
+#define END_OF_FILE -1
+
+// Overwrite n bytes of a file at offset, or append them at END_OF_FILE
+static bool patch_file(const string& path, long offset, const void* bytes, size_t n){
+	FILE* file = fopen(path.c_str(), "r+b");
+	if(!file) return false;
+	const bool ok = fseek(file, offset == END_OF_FILE ? 0 : offset, offset == END_OF_FILE ? SEEK_END : SEEK_SET) == 0
+		&& fwrite(bytes, 1, n, file) == n;
+	return fclose(file) == 0 && ok;
+}
+
+// Every access of a trace, decoded a chunk at a time
+static vector<uint64_t> read_trace(const TraceReader& reader){
+	TraceFileStream<uint64_t> stream(reader);
+	vector<uint64_t> pages, chunk(1000);
+	size_t n;
+	while((n = stream.next(chunk.data(), chunk.size())) > 0){
+		pages.insert(pages.end(), chunk.begin(), chunk.begin() + n);
+	}
+	return pages;
+}
+
+/*\brief Trace files give back what was written, and refuse what is corrupt
+ *
+ * Every width and encoding round-trips ids with large jumps both ways and
+ * the extremes of the width, written in uneven pieces from 32- and 64-bit
+ * ids. Raw traces are also mapped in place, and replaying a trace gives the
+ * hits of replaying its ids. A bad header or a raw trace too short for its
+ * count does not open; a varint trace cut short, or with a varint longer
+ * than any id, ends where the valid data ends.
+ */
+static void check_trace_files(){
+	const char* check = "Trace files round-trip";
+	int mismatches = 0, runs = 0;
+	const string directory = scratch_directory();
+	if(directory.empty()){
+		expect(mismatches, runs, check, false, "no scratch directory");
+		report(check, mismatches, runs);
+		return;
+	}
+	const string path = directory + "/check.trace";
+
+	Xoshiro256 random(5);
+	vector<uint64_t> wide(100000);
+	for(uint64_t& page : wide) page = random.below(4) ? random.below(1000) : random.next();
+	wide[10] = 0;
+	wide[11] = UINT64_MAX - 1;
+	wide[12] = 0;
+	wide[13] = UINT32_MAX;
+	vector<uint32_t> narrow(5000);
+	for(uint32_t& page : narrow) page = random.next();
+	for(unsigned int width : {4u, 8u}){
+		for(TraceEncoding encoding : {TRACE_RAW, TRACE_DELTA_VARINT}){
+			const string where = std::to_string(width) + "-byte " + (encoding == TRACE_RAW ? "raw" : "varint") + " trace";
+			vector<uint64_t> expected;
+			for(uint64_t page : wide) expected.push_back(width == 4 ? (uint32_t)page : page);
+			expected.insert(expected.end(), narrow.begin(), narrow.end());
+			TraceWriter writer;
+			const bool written = writer.open(path, width, encoding) && writer.write(wide.data(), 1)
+				&& writer.write(wide.data() + 1, 70000) && writer.write(wide.data() + 70001, wide.size() - 70001)
+				&& writer.write(narrow.data(), narrow.size()) && writer.close();
+			expect(mismatches, runs, check, written, "could not write a " + where);
+
+			TraceReader reader;
+			expect(mismatches, runs, check, reader.open(path) && reader.size() == expected.size() && reader.width() == width && reader.encoding() == encoding,
+				"header of a " + where + " read back wrong");
+			expect(mismatches, runs, check, read_trace(reader) == expected, "accesses of a " + where + " read back wrong");
+			expect(mismatches, runs, check, trace_largest_page(reader) == *std::max_element(expected.begin(), expected.end()), "wrong largest page of a " + where);
+			const PageSpan<uint32_t> span32 = reader.pages32();
+			const PageSpan<uint64_t> span64 = reader.pages64();
+			const bool mapped = encoding == TRACE_RAW && width == 4 ? span32.size == expected.size() && std::equal(span32.begin(), span32.end(), expected.begin())
+				: encoding == TRACE_RAW ? span64.size == expected.size() && std::equal(span64.begin(), span64.end(), expected.begin())
+				: span32.data == NULL && span64.data == NULL;
+			expect(mismatches, runs, check, mapped, "the mapping of a " + where + " is wrong");
+
+			LruPolicy<uint64_t> traced(100), direct(100);
+			expect(mismatches, runs, check, simulate_trace(reader, traced) == direct.access_batch(expected.data(), expected.size(), NULL),
+				"replaying a " + where + " gives other hits than its ids");
+			if(width == 4){
+				vector<uint32_t> ids(expected.begin(), expected.end());
+				LruPolicy<uint32_t> traced32(100), direct32(100);
+				expect(mismatches, runs, check, simulate_trace(reader, traced32) == direct32.access_batch(ids.data(), ids.size(), NULL),
+					"replaying a " + where + " with 32-bit ids gives other hits than its ids");
+			}
+			reader.close();
+
+			// Cut short by a few bytes
+			struct stat info;
+			stat(path.c_str(), &info);
+			expect(mismatches, runs, check, truncate(path.c_str(), info.st_size - 3) == 0, "could not truncate a " + where);
+			if(encoding == TRACE_RAW){
+				expect(mismatches, runs, check, !reader.open(path), "a truncated " + where + " opened");
+				continue;
+			}
+			expect(mismatches, runs, check, reader.open(path), "a truncated " + where + " did not open");
+			const vector<uint64_t> decoded = read_trace(reader);
+			expect(mismatches, runs, check, decoded.size() < expected.size() && std::equal(decoded.begin(), decoded.end(), expected.begin()),
+				"a truncated " + where + " decoded " + std::to_string(decoded.size()) + " accesses, not a prefix");
+		}
+	}
+
+	// A varint longer than any id after three valid ones
+	const vector<uint64_t> valid = {5, 6, 7};
+	TraceWriter writer;
+	const unsigned char overlong[11] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01};
+	const uint64_t count = 5;
+	expect(mismatches, runs, check, writer.open(path, 8, TRACE_DELTA_VARINT) && writer.write(valid.data(), valid.size()) && writer.close()
+		&& patch_file(path, END_OF_FILE, overlong, sizeof(overlong)) && patch_file(path, 8, &count, sizeof(count)), "could not write an overlong varint");
+	TraceReader reader;
+	expect(mismatches, runs, check, reader.open(path) && read_trace(reader) == valid, "an overlong varint was decoded");
+	reader.close();
+
+	// Corrupt headers of a valid raw trace
+	struct Corruption {
+		const char* name;
+		long offset;
+		uint64_t value;
+		size_t bytes;
+	};
+	const Corruption corruptions[] = {{"magic", 0, 'X', 1}, {"version", 4, 2, 2}, {"width", 6, 5, 1}, {"encoding", 7, 9, 1}, {"count", 8, 1 << 20, 8}};
+	for(const Corruption& corruption : corruptions){
+		expect(mismatches, runs, check, writer.open(path, 4) && writer.write(narrow.data(), narrow.size()) && writer.close()
+			&& patch_file(path, corruption.offset, &corruption.value, corruption.bytes), "could not corrupt the " + string(corruption.name));
+		expect(mismatches, runs, check, !reader.open(path), string("a trace with a bad ") + corruption.name + " opened");
+	}
+	expect(mismatches, runs, check, truncate(path.c_str(), 10) == 0 && !reader.open(path), "a trace shorter than its header opened");
+	expect(mismatches, runs, check, !reader.open(directory + "/missing.trace"), "a missing trace opened");
+
+	unlink(path.c_str());
+	expect(mismatches, runs, check, rmdir(directory.c_str()) == 0, "files left in " + directory);
+	report(check, mismatches, runs);
+}
+
+// What one run of traceconv produced
+struct Conversion {
+	int status;
+	bool written;  // whether the output trace exists
+	vector<uint64_t> pages;
+	TraceEncoding encoding;
+	unsigned int width;
+	long skipped;  // lines reported skipped, -1 if not reported
+};
+
+// Run traceconv on the given input text, then read back what it wrote and
+// remove its files
+static Conversion convert(const string& directory, const string& format, const string& input, const string& options){
+	const string input_path = directory + "/input", output_path = directory + "/output.trace", log_path = directory + "/log";
+	FILE* file = fopen(input_path.c_str(), "wb");
+	if(file){
+		fwrite(input.data(), 1, input.size(), file);
+		fclose(file);
+	}
+	const string command = string(TRACECONV) + " " + format + " " + input_path + " " + output_path + " " + options + " 2> " + log_path;
+	const int status = system(command.c_str());
+	Conversion conversion = {WIFEXITED(status) ? WEXITSTATUS(status) : -1, file_exists(output_path), {}, TRACE_RAW, 0, -1};
+	TraceReader reader;
+	if(reader.open(output_path)){
+		conversion.pages = read_trace(reader);
+		conversion.encoding = reader.encoding();
+		conversion.width = reader.width();
+	}
+	reader.close();
+	FILE* log = fopen(log_path.c_str(), "r");
+	unsigned long long accesses, skipped;
+	if(log && fscanf(log, "%llu page accesses written, %llu lines skipped", &accesses, &skipped) == 2){
+		conversion.skipped = skipped;
+	}
+	if(log) fclose(log);
+	unlink(input_path.c_str());
+	unlink(output_path.c_str());
+	unlink(log_path.c_str());
+	return conversion;
+}
+
+// Page id of a page on a device, as traceconv folds them
+static uint64_t folded(uint64_t device, uint64_t page){
+	return device << 48 | page;
+}
+
+/*\brief traceconv turns each block trace format into the right page ids
+ *
+ * Runs the converter on small inputs of every format: headers, blank and
+ * malformed lines are skipped, requests cover every page they touch, devices
+ * are folded into the ids or selected, and the width, page size, dense and
+ * varint options apply. Requests that are too long, overflow or would write
+ * the reserved largest id are skipped, a width-4 output whose ids do not fit
+ * fails without leaving a file, and threads do not change the output.
+ */
+static void check_traceconv(){
+	const char* check = "traceconv parses block traces";
+	int mismatches = 0, runs = 0;
+	const string directory = scratch_directory();
+	if(directory.empty() || !file_exists(TRACECONV)){
+		expect(mismatches, runs, check, false, "no scratch directory, or no " TRACECONV " to run");
+		report(check, mismatches, runs);
+		return;
+	}
+	struct Case {
+		const char* name;
+		const char* format;
+		string input;
+		const char* options;
+		vector<uint64_t> pages;
+		long skipped;
+	};
+	const string msr = "Timestamp,Hostname,DiskNumber,Type,Offset,Size,ResponseTime\n"
+		"128166372003061629,hm,0,Read,4000,200,1\r\n"
+		"\n"
+		"128166372003061630,hm,2,Write,8192,0,1\n"
+		"garbage\n"
+		"128166372003061631,hm,1,Read,12288,8192,1";
+	const Case cases[] = {
+		{"msr", "msr", msr, "", {0, 1, folded(2, 2), folded(1, 3), folded(1, 4)}, 2},
+		{"msr --page-size", "msr", msr, "--page-size 8192", {0, folded(2, 1), folded(1, 1), folded(1, 2)}, 2},
+		{"msr --device", "msr", msr, "--device 1", {3, 4}, 2},
+		{"msr --dense", "msr", msr, "--dense --width 4", {0, 1, 2, 3, 4}, 2},
+		{"msr --varint", "msr", msr, "--varint", {0, 1, folded(2, 2), folded(1, 3), folded(1, 4)}, 2},
+		{"spc", "spc", "0,8,4096,r,0.0\n1,0,1,w,0.1\n0,15,1024,r,0.2\nASU,LBA\n", "", {1, folded(1, 0), 1, 2}, 1},
+		{"arc", "arc", "8 16 0 1\n  0 1 0 2\n\nx y\n", "", {1, 2, 0}, 1},
+		{"last device and page", "msr", "0,h,65535,Read,1152921504606838784,4096,1\n0,h,65535,Read,1152921504606842880,4096,1\n", "",
+			{folded(65535, (((uint64_t)1 << 48) - 2))}, 1},
+		{"reserved id with --device", "msr", "0,h,0,Read,18446744073709551614,1,1\n0,h,0,Read,18446744073709551615,1,1\n", "--device 0 --page-size 1",
+			{UINT64_MAX - 1}, 1},
+		{"device too large", "msr", "0,h,65536,Read,0,4096,1\n", "", {}, 1},
+		{"request too long", "msr", "0,h,0,Read,0,1000000000000000,1\n0,h,0,Read,0,4294967297,1\n", "", {}, 2},
+		{"offset overflow", "spc", "0,36028797018963968,512,r,0\n", "", {}, 1},
+		{"end overflow", "msr", "0,h,0,Read,18446744073709551615,2,1\n", "--device 0", {}, 1},
+	};
+	for(const Case& test : cases){
+		const Conversion conversion = convert(directory, test.format, test.input, test.options);
+		const string where = string(test.name) + " with options '" + test.options + "'";
+		expect(mismatches, runs, check, conversion.status == 0 && conversion.pages == test.pages, where + " converted to the wrong pages");
+		expect(mismatches, runs, check, conversion.skipped == test.skipped,
+			where + " skipped " + std::to_string(conversion.skipped) + " lines, not " + std::to_string(test.skipped));
+	}
+
+	Conversion conversion = convert(directory, "msr", msr, "--varint --width 4 --dense");
+	expect(mismatches, runs, check, conversion.width == 4 && conversion.encoding == TRACE_DELTA_VARINT, "--width and --varint do not set the header");
+	conversion = convert(directory, "msr", msr, "--width 4");
+	expect(mismatches, runs, check, conversion.status != 0 && !conversion.written, "a folded id too wide for 4 bytes was written");
+	conversion = convert(directory, "msr", "0,h,0,Read,17592186040320,4096,1\n", "--width 4");
+	expect(mismatches, runs, check, conversion.status != 0 && !conversion.written, "the reserved id 0xFFFFFFFF was written with --width 4");
+	conversion = convert(directory, "msr", "0,h,0,Read,17592186036224,4096,1\n", "--width 4");
+	expect(mismatches, runs, check, conversion.status == 0 && conversion.pages == vector<uint64_t>(1, UINT32_MAX - 1), "the largest 4-byte id was not written");
+	expect(mismatches, runs, check, convert(directory, "csv", msr, "").status != 0, "an unknown format was accepted");
+	expect(mismatches, runs, check, convert(directory, "msr", msr, "--width 5").status != 0, "--width 5 was accepted");
+	expect(mismatches, runs, check, convert(directory, "msr", msr, "--page-size 0").status != 0, "--page-size 0 was accepted");
+
+	// Many lines, split between threads
+	string many;
+	Xoshiro256 random(13);
+	for(int line = 0; line < 50000; line++){
+		many += "0,h," + std::to_string(random.below(4)) + ",Read," + std::to_string(random.below(1 << 30)) + "," + std::to_string(random.below(20000)) + ",1\n";
+	}
+	const Conversion one = convert(directory, "msr", many, "--threads 1");
+	const Conversion four = convert(directory, "msr", many, "--threads 4");
+	expect(mismatches, runs, check, one.status == 0 && !one.pages.empty() && one.pages == four.pages, "the output depends on the number of threads");
+
+	expect(mismatches, runs, check, rmdir(directory.c_str()) == 0, "files left in " + directory);
+	report(check, mismatches, runs);
+}
+
+// Whether dense renames pages one to one, each page to a single id and back
+template <typename PageId>
+static bool renames(const vector<PageId>& pages, const vector<uint32_t>& dense){
+	unordered_map<PageId, uint32_t> forward;
+	unordered_map<uint32_t, PageId> backward;
+	for(size_t i = 0; i < pages.size(); i++){
+		if(forward.emplace(pages[i], dense[i]).first->second != dense[i]) return false;
+		if(backward.emplace(dense[i], pages[i]).first->second != pages[i]) return false;
+	}
+	return true;
+}
+
+// Dense ids in order of first appearance, as remap_dense must give them
+template <typename PageId>
+static vector<uint32_t> ref_remap(const vector<PageId>& pages){
+	unordered_map<PageId, uint32_t> ids;
+	vector<uint32_t> dense;
+	for(PageId page : pages) dense.push_back(ids.emplace(page, ids.size()).first->second);
+	return dense;
+}
+
+template <typename PageId>
+static void check_remap_of(int& mismatches, int& runs, const char* check, const string& name, const vector<PageId>& pages){
+	const vector<uint32_t> expected = ref_remap(pages);
+	const uint32_t distinct = expected.empty() ? 0 : *std::max_element(expected.begin(), expected.end()) + 1;
+	vector<uint32_t> dense(pages.size());
+	expect(mismatches, runs, check, remap_dense(pages.data(), pages.size(), dense.data()) == distinct && dense == expected,
+		"remap_dense of " + name + " is not in order of first appearance");
+	PageRemapper remapper;
+	bool incremental = true;
+	for(size_t i = 0; i < pages.size(); i++) incremental = incremental && remapper.map(pages[i]) == expected[i];
+	expect(mismatches, runs, check, incremental && remapper.size() == distinct, "PageRemapper differs from remap_dense on " + name);
+
+	const DenseWorkload workload(pages);
+	const vector<uint32_t>& used = workload.pages();
+	expect(mismatches, runs, check, used.size() == pages.size() && renames(pages, used), "DenseWorkload of " + name + " is not a renaming");
+	expect(mismatches, runs, check, std::all_of(used.begin(), used.end(), [&](uint32_t page){ return page < workload.universe; }),
+		"DenseWorkload of " + name + " has pages outside its universe");
+	expect(mismatches, runs, check, workload.universe <= 2 * pages.size() + DenseWorkload::DENSE_SLACK,
+		"DenseWorkload of " + name + " has a universe of " + std::to_string(workload.universe));
+}
+
+/*\brief Remapping gives dense ids that change nothing but the names
+ *
+ * remap_dense and PageRemapper hand out ids in order of first appearance,
+ * also in place. DenseWorkload keeps small workloads and renames the rest
+ * one to one within a small universe, so the wrappers give the same hits on
+ * ids scattered over 32 or 64 bits as on the workload itself.
+ */
+static void check_remap(const vector<CheckWorkload>& workloads){
+	const char* check = "Remapping only renames pages";
+	int mismatches = 0, runs = 0;
+	const DensePolicy policies[] = {PRP_FIFO, PRP_LRU, PRP_ARC, PRP_CLOCK_PRO, PRP_LIRS};
+	const char* names[] = {"FIFO", "LRU", "ARC", "CLOCK-Pro", "LIRS"};
+	for(const CheckWorkload& workload : workloads){
+		vector<uint64_t> scattered(workload.pages.begin(), workload.pages.end());
+		for(uint64_t& page : scattered) page = page * SCATTER_MULTIPLIER;
+		vector<uint32_t> scattered32(scattered.begin(), scattered.end());
+		vector<uint64_t> wide(workload.pages.begin(), workload.pages.end());
+		check_remap_of(mismatches, runs, check, workload.name, workload.pages);
+		check_remap_of(mismatches, runs, check, workload.name + " scattered", scattered);
+		check_remap_of(mismatches, runs, check, workload.name + " scattered over 32 bits", scattered32);
+		check_remap_of(mismatches, runs, check, workload.name + " widened", wide);
+
+		vector<uint32_t> in_place(scattered32);
+		remap_dense(in_place.data(), in_place.size(), in_place.data());
+		expect(mismatches, runs, check, in_place == ref_remap(scattered32), "remap_dense in place differs on " + workload.name);
+		if(!workload.pages.empty()){
+			const DenseWorkload small(workload.pages);
+			expect(mismatches, runs, check, &small.pages() == &workload.pages, "a small workload " + workload.name + " was copied");
+		}
+
+		for(size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); p++){
+			for(unsigned int memsize : {1u, 16u, 129u}){
+				const int expected = policies[p](DenseWorkload(workload.pages), memsize);
+				expect(mismatches, runs, check, policies[p](DenseWorkload(scattered), memsize) == expected && policies[p](DenseWorkload(scattered32), memsize) == expected,
+					string(names[p]) + " hits change when " + workload.name + " is scattered, with memsize " + std::to_string(memsize));
+			}
+		}
+	}
+	const vector<uint64_t> extremes = {UINT64_MAX - 1, 0, UINT64_MAX - 1, 1, (uint64_t)1 << 63, 0};
+	check_remap_of(mismatches, runs, check, "extreme ids", extremes);
+	check_remap_of(mismatches, runs, check, "no ids", vector<uint64_t>());
+	report(check, mismatches, runs);
+}
+
+/*\brief Checks the policies against reference implementations
+ *
+ * Exits with status 1 if any check fails, printing the first mismatches.
+ */
+int main(){
+	printf("find_page kernel: %s\n", find_page_kernel());
+	const vector<CheckWorkload> workloads = check_workloads(CHECK_LENGTH);
+	const vector<CheckWorkload> short_workloads = check_workloads(OPT_CHECK_LENGTH);
+
+	check_reference("FIFO matches the original", PRP_FIFO<uint32_t>, ref_fifo, workloads);
+	check_reference("LRU matches the original", PRP_LRU<uint32_t>, ref_lru, workloads);
+	check_reference("OPT matches brute-force Belady", PRP_OPT<uint32_t>, ref_opt, short_workloads);
+	check_reference("ARC matches Megiddo & Modha", PRP_ARC<uint32_t>, ref_arc, workloads);
+	check_reference("CAR matches Bansal & Modha", PRP_CAR<uint32_t>, ref_car, workloads);
+	check_reference("LIRS matches Jiang & Zhang", PRP_LIRS<uint32_t>, ref_lirs, workloads);
+	check_reference("CLOCK-Pro matches Jiang, Chen, Zhang", PRP_CLOCK_PRO<uint32_t>, ref_clock_pro, workloads);
+
+	check_curve("OPT hit curve matches PRP_OPT", OPT_hit_curve<uint32_t>, PRP_OPT<uint32_t>, short_workloads);
+	check_curve("LRU hit curve matches PRP_LRU", LRU_hit_curve<uint32_t>, PRP_LRU<uint32_t>, short_workloads);
+
+	check_index_modes("FIFO index modes agree", ENGINE_RUNS(FifoPolicy), true, workloads);
+	check_index_modes("OPT index modes agree", run_opt<uint32_t>, run_opt<uint64_t>, true, workloads);
+	check_index_modes("RAND index modes agree", run_rand<uint32_t>, run_rand<uint64_t>, true, workloads);
+	check_index_modes("LRU index modes agree", ENGINE_RUNS(LruPolicy), true, workloads);
+	check_index_modes("CLOCK index modes agree", ENGINE_RUNS(ClockPolicy), true, workloads);
+	check_index_modes("ARC index modes agree", ENGINE_RUNS(ArcPolicy), true, workloads);
+	check_index_modes("CAR index modes agree", ENGINE_RUNS(CarPolicy), true, workloads);
+	check_index_modes("CLOCK-Pro index modes agree", ENGINE_RUNS(ClockProPolicy), true, workloads);
+	check_index_modes("LIRS index modes agree", ENGINE_RUNS(LirsPolicy), true, workloads);
+	// The frequency sketch hashes the ids, so scattered ids count differently
+	check_index_modes("W-TinyLFU index modes agree", ENGINE_RUNS(WTinyLfuPolicy), false, workloads);
+
+	check_rand_seeds(workloads);
+	check_task_pool();
+	check_trace_cache();
+	check_streams();
+	check_zipf();
+	check_trace_files();
+	check_traceconv();
+	check_remap(workloads);
+
+	if(failures){
+		printf("%d checks FAILED\n", failures);
+		return 1;
+	}
+	printf("all checks passed\n");
+	return 0;
+}
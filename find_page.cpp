@@ -0,0 +1,121 @@
+#include "find_page.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FIND_PAGE_X86 1
+#endif
+
+template <typename PageId>
+static size_t find_scalar(const PageId* frames, size_t n, PageId page) {
+    for (size_t i = 0; i < n; i++) {
+        if (frames[i] == page) return i;
+    }
+    return n;
+}
+
+#ifdef FIND_PAGE_X86
+
+__attribute__((target("sse4.1")))
+static size_t find_sse41_32(const uint32_t* frames, size_t n, uint32_t page) {
+    const __m128i key = _mm_set1_epi32(page);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128i ids = _mm_loadu_si128(reinterpret_cast<const __m128i*>(frames + i));
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(ids, key)));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + find_scalar(frames + i, n - i, page);
+}
+
+__attribute__((target("sse4.1")))
+static size_t find_sse41_64(const uint64_t* frames, size_t n, uint64_t page) {
+    const __m128i key = _mm_set1_epi64x(page);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128i ids = _mm_loadu_si128(reinterpret_cast<const __m128i*>(frames + i));
+        const int mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(ids, key)));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + find_scalar(frames + i, n - i, page);
+}
+
+// Two vectors per iteration, so one branch covers 16 ids
+__attribute__((target("avx2")))
+static size_t find_avx2_32(const uint32_t* frames, size_t n, uint32_t page) {
+    const __m256i key = _mm256_set1_epi32(page);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(frames + i));
+        const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(frames + i + 8));
+        const __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi32(low, key), _mm256_cmpeq_epi32(high, key));
+        if (!_mm256_testz_si256(hits, hits)) {
+            const unsigned int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(low, key)))
+                | _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(high, key))) << 8;
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + find_sse41_32(frames + i, n - i, page);
+}
+
+__attribute__((target("avx2")))
+static size_t find_avx2_64(const uint64_t* frames, size_t n, uint64_t page) {
+    const __m256i key = _mm256_set1_epi64x(page);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(frames + i));
+        const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(frames + i + 4));
+        const __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi64(low, key), _mm256_cmpeq_epi64(high, key));
+        if (!_mm256_testz_si256(hits, hits)) {
+            const unsigned int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(low, key)))
+                | _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(high, key))) << 4;
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + find_sse41_64(frames + i, n - i, page);
+}
+
+#endif
+
+enum FindPageKernel { KERNEL_SCALAR, KERNEL_SSE41, KERNEL_AVX2 };
+
+typedef size_t (*FindPage32)(const uint32_t*, size_t, uint32_t);
+typedef size_t (*FindPage64)(const uint64_t*, size_t, uint64_t);
+
+struct FindPageKernels {
+    FindPageKernel kernel;
+    FindPage32 find32;
+    FindPage64 find64;
+};
+
+static FindPageKernels select_kernels() {
+#ifdef FIND_PAGE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return {KERNEL_AVX2, find_avx2_32, find_avx2_64};
+    if (__builtin_cpu_supports("sse4.1")) return {KERNEL_SSE41, find_sse41_32, find_sse41_64};
+#endif
+    return {KERNEL_SCALAR, find_scalar<uint32_t>, find_scalar<uint64_t>};
+}
+
+// Selected on first use rather than during static initialization, so that
+// policies constructed by the static initializers of other files can
+// already search their frames
+static const FindPageKernels& kernels() {
+    static const FindPageKernels selected = select_kernels();
+    return selected;
+}
+
+size_t find_page(const uint32_t* frames, size_t n, uint32_t page) {
+    return kernels().find32(frames, n, page);
+}
+
+size_t find_page(const uint64_t* frames, size_t n, uint64_t page) {
+    return kernels().find64(frames, n, page);
+}
+
+const char* find_page_kernel() {
+    switch (kernels().kernel) {
+    case KERNEL_AVX2: return "avx2";
+    case KERNEL_SSE41: return "sse4.1";
+    default: return "scalar";
+    }
+}
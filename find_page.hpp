@@ -0,0 +1,26 @@
+#pragma once
+#ifndef FIND_PAGE_HPP_
+#define FIND_PAGE_HPP_
+
+#include <cstdint>
+#include <cstddef>
+
+/*!
+ *  \brief Find a page in a contiguous array of frames.
+ *
+ *  Compares 8 (AVX2) or 4 (SSE4.1) 32-bit ids per instruction, or half as many
+ *  64-bit ids, with a scalar fallback. The widest kernel the CPU supports is
+ *  picked once at startup, so the same binary runs anywhere.
+ *
+ *  \param frames Page ids to search
+ *  \param n Number of page ids
+ *  \param page Page id to look for
+ *  \return Position of the first match, or n if page is absent
+ */
+size_t find_page(const uint32_t* frames, size_t n, uint32_t page);
+size_t find_page(const uint64_t* frames, size_t n, uint64_t page);
+
+// Name of the kernel in use: "avx2", "sse4.1" or "scalar"
+const char* find_page_kernel();
+
+#endif /* end of include guard: FIND_PAGE_HPP_ */
@@ -0,0 +1,137 @@
+#pragma once
+#ifndef FLAT_MAP_HPP_
+#define FLAT_MAP_HPP_
+
+#include <vector>
+#include <utility>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+/*!
+ *  \brief Open-addressing hash map from integer keys to small values.
+ *
+ *  Keys and values sit side by side in one power-of-two array probed
+ *  linearly, so a lookup touches a single cache line in the common case and
+ *  inserting never allocates once the map is sized. The table is kept at most
+ *  half full and doubles when it would pass that. Erasing shifts the rest of
+ *  the probe run back, so no tombstones are ever needed and lookups do not slow
+ *  down as keys come and go. The largest key of the type marks empty buckets
+ *  and cannot be stored.
+ */
+template <typename Key, typename Value>
+class FlatHashMap {
+public:
+    static const Key EMPTY = std::numeric_limits<Key>::max();
+
+    // Size the table for capacity keys without growing
+    explicit FlatHashMap(size_t capacity = 0) : size_(0) {
+        size_t buckets = 2;
+        shift_ = 63;
+        while (buckets < 2 * capacity) {
+            buckets *= 2;
+            shift_--;
+        }
+        mask_ = buckets - 1;
+        buckets_.assign(buckets, Bucket{Key(EMPTY), Value()});
+    }
+
+    size_t size() const { return size_; }
+
+    void clear() {
+        for (Bucket& bucket : buckets_) bucket.key = EMPTY;
+        size_ = 0;
+    }
+
+    // The value of key, or NULL if it is absent
+    Value* find(Key key) {
+        for (size_t b = home(key); buckets_[b].key != EMPTY; b = (b + 1) & mask_) {
+            if (buckets_[b].key == key) return &buckets_[b].value;
+        }
+        return NULL;
+    }
+
+    const Value* find(Key key) const {
+        return const_cast<FlatHashMap*>(this)->find(key);
+    }
+
+    /*!
+     *  \brief Insert key with value unless key is already present.
+     *  \return The stored value, and whether it was inserted
+     */
+    std::pair<Value*, bool> emplace(Key key, Value value) {
+        if (2 * (size_ + 1) > buckets_.size()) {
+            grow();
+        }
+        size_t b = home(key);
+        for (; buckets_[b].key != EMPTY; b = (b + 1) & mask_) {
+            if (buckets_[b].key == key) return std::make_pair(&buckets_[b].value, false);
+        }
+        buckets_[b].key = key;
+        buckets_[b].value = value;
+        size_++;
+        return std::make_pair(&buckets_[b].value, true);
+    }
+
+    // The value of key, inserting a default one if it is absent
+    Value& operator[](Key key) {
+        return *emplace(key, Value()).first;
+    }
+
+    // Remove key, returns false if it was absent
+    bool erase(Key key) {
+        size_t hole = home(key);
+        while (buckets_[hole].key != key) {
+            if (buckets_[hole].key == EMPTY) return false;
+            hole = (hole + 1) & mask_;
+        }
+        // Backward shift: pull later entries of the run into the hole unless
+        // that would move them in front of their home bucket
+        for (size_t b = (hole + 1) & mask_; buckets_[b].key != EMPTY; b = (b + 1) & mask_) {
+            if (((b - home(buckets_[b].key)) & mask_) >= ((b - hole) & mask_)) {
+                buckets_[hole] = buckets_[b];
+                hole = b;
+            }
+        }
+        buckets_[hole].key = EMPTY;
+        size_--;
+        return true;
+    }
+
+    // Hint that key is about to be looked up
+    void prefetch(Key key) const {
+        __builtin_prefetch(&buckets_[home(key)]);
+    }
+
+private:
+    struct Bucket {
+        Key key;
+        Value value;
+    };
+
+    size_t home(Key key) const {
+        // Fibonacci hashing, the top bits of the product are the best mixed
+        return static_cast<size_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL) >> shift_);
+    }
+
+    void grow() {
+        std::vector<Bucket> old;
+        old.swap(buckets_);
+        buckets_.assign(2 * old.size(), Bucket{Key(EMPTY), Value()});
+        mask_ = buckets_.size() - 1;
+        shift_--;
+        for (const Bucket& bucket : old) {
+            if (bucket.key == EMPTY) continue;
+            size_t b = home(bucket.key);
+            while (buckets_[b].key != EMPTY) b = (b + 1) & mask_;
+            buckets_[b] = bucket;
+        }
+    }
+
+    std::vector<Bucket> buckets_;
+    size_t mask_;
+    unsigned int shift_;
+    size_t size_;
+};
+
+#endif /* end of include guard: FLAT_MAP_HPP_ */
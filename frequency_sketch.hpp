@@ -0,0 +1,119 @@
+#pragma once
+#ifndef FREQUENCY_SKETCH_HPP_
+#define FREQUENCY_SKETCH_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+/*!
+ *  \brief Count-Min sketch of recent access frequencies with 4 bit counters.
+ *
+ *  Estimates how often each key was seen lately, for the admission filter of
+ *  TinyLFU. A key hashes to one 64 byte block of eight words and takes one of
+ *  the sixteen 4 bit counters in each of four word pairs, so counting a key or
+ *  estimating its frequency touches a single cache line. The estimate is the
+ *  smallest of the four counters, which saturate at 15. After 10 increments
+ *  per key of capacity every counter is halved, so old popularity fades and
+ *  the estimate tracks the recent past.
+ */
+class FrequencySketch {
+public:
+    static const unsigned int MAX_COUNT = 15;
+
+    // Size the sketch for a cache of capacity keys
+    explicit FrequencySketch(size_t capacity)
+        : sampleSize_(10 * std::max(capacity, static_cast<size_t>(1))) {
+        // About one word of sixteen counters per key
+        size_t blocks = 1;
+        while (blocks * WORDS_PER_BLOCK < capacity) blocks *= 2;
+        blocks_.resize(blocks);
+        blockMask_ = blocks - 1;
+        clear();
+    }
+
+    void clear() {
+        for (Block& block : blocks_) {
+            std::fill(block.words, block.words + WORDS_PER_BLOCK, 0);
+        }
+        additions_ = 0;
+    }
+
+    // Estimated number of recent accesses to key, at most MAX_COUNT
+    unsigned int frequency(uint64_t key) const {
+        const uint64_t hash = spread(key);
+        const uint64_t* words = blocks_[hash & blockMask_].words;
+        unsigned int count = MAX_COUNT;
+        for (unsigned int depth = 0; depth < DEPTH; depth++) {
+            const unsigned int shift = counterShift(hash, depth);
+            count = std::min(count, static_cast<unsigned int>(words[counterWord(hash, depth)] >> shift) & MAX_COUNT);
+        }
+        return count;
+    }
+
+    // Count an access to key, halving every counter once the sample is full
+    void increment(uint64_t key) {
+        const uint64_t hash = spread(key);
+        uint64_t* words = blocks_[hash & blockMask_].words;
+        bool added = false;
+        for (unsigned int depth = 0; depth < DEPTH; depth++) {
+            const unsigned int shift = counterShift(hash, depth);
+            uint64_t& word = words[counterWord(hash, depth)];
+            if (((word >> shift) & MAX_COUNT) != MAX_COUNT) {
+                word += 1ULL << shift;
+                added = true;
+            }
+        }
+        if (added && ++additions_ == sampleSize_) {
+            halve();
+        }
+    }
+
+    // Hint that key is about to be counted
+    void prefetch(uint64_t key) const {
+        __builtin_prefetch(&blocks_[spread(key) & blockMask_]);
+    }
+
+private:
+    static const unsigned int WORDS_PER_BLOCK = 8;
+    static const unsigned int DEPTH = 4;
+
+    struct alignas(64) Block {
+        uint64_t words[WORDS_PER_BLOCK];
+    };
+
+    // splitmix64 finalizer, so dense page numbers spread over the blocks
+    static uint64_t spread(uint64_t key) {
+        key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+        return key ^ (key >> 31);
+    }
+
+    // The low bits of the hash pick the block and the high 32 bits the
+    // counters, one byte per row: its low bit picks the word of the row's
+    // pair and the next four bits the counter within it
+    static unsigned int counterWord(uint64_t hash, unsigned int depth) {
+        return 2 * depth + ((hash >> (32 + 8 * depth)) & 1);
+    }
+
+    static unsigned int counterShift(uint64_t hash, unsigned int depth) {
+        return 4 * ((hash >> (33 + 8 * depth)) & 15);
+    }
+
+    void halve() {
+        for (Block& block : blocks_) {
+            for (uint64_t& word : block.words) {
+                word = (word >> 1) & 0x7777777777777777ULL;
+            }
+        }
+        additions_ /= 2;
+    }
+
+    std::vector<Block> blocks_;
+    size_t blockMask_;
+    size_t additions_;
+    size_t sampleSize_;
+};
+
+#endif /* end of include guard: FREQUENCY_SKETCH_HPP_ */
@@ -0,0 +1,87 @@
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "perf_counters.hpp"
+
+static const uint64_t EVENT_CONFIG[NUM_PERF_EVENTS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static const char* EVENT_NAME[NUM_PERF_EVENTS] = {
+    "cycles",
+    "instructions",
+    "llc_misses",
+    "branch_misses"
+};
+
+// glibc has no wrapper for this system call
+static int perf_event_open(perf_event_attr* attr, pid_t pid, int cpu, int group, unsigned long flags) {
+    return syscall(SYS_perf_event_open, attr, pid, cpu, group, flags);
+}
+
+PerfCounters::PerfCounters() {
+    for (int event = 0; event < NUM_PERF_EVENTS; event++) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = EVENT_CONFIG[event];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // This thread, on whichever CPU it runs
+        fds_[event] = perf_event_open(&attr, 0, -1, -1, 0);
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds_) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+bool PerfCounters::available() const {
+    for (int fd : fds_) {
+        if (fd >= 0) return true;
+    }
+    return false;
+}
+
+void PerfCounters::start() {
+    for (int fd : fds_) {
+        if (fd < 0) continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+PerfSample PerfCounters::stop() {
+    for (int fd : fds_) {
+        if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+    PerfSample sample;
+    for (int event = 0; event < NUM_PERF_EVENTS; event++) {
+        sample.counts[event] = -1;
+        // value, time enabled, time running
+        uint64_t values[3];
+        if (fds_[event] < 0 || read(fds_[event], values, sizeof(values)) != sizeof(values)) {
+            continue;
+        }
+        if (values[2] == 0) {
+            // Never got a hardware counter while enabled
+            continue;
+        }
+        sample.counts[event] = static_cast<double>(values[0]) * values[1] / values[2];
+    }
+    return sample;
+}
+
+const char* PerfCounters::name(PerfEvent event) {
+    return EVENT_NAME[event];
+}
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef PERF_COUNTERS_HPP_
+#define PERF_COUNTERS_HPP_
+
+#include <cstdint>
+
+// Hardware events counted around a measured region
+enum PerfEvent {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    NUM_PERF_EVENTS
+};
+
+// Event counts of one measured region, negative for events that could not be counted
+struct PerfSample {
+    double counts[NUM_PERF_EVENTS];
+};
+
+/*!
+ *  \brief Hardware performance counters of the calling thread, via perf_event_open.
+ *
+ *  Counts user-space cycles, instructions, last level cache misses and branch
+ *  mispredicts between start() and stop(). Each event is opened on its own, so
+ *  a machine or VM lacking one event still reports the others, and counts are
+ *  scaled up when the kernel had to multiplex the counters. If perf events are
+ *  not permitted at all (see /proc/sys/kernel/perf_event_paranoid), available()
+ *  is false and every count is negative. Only counts the thread that created it.
+ */
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    // Whether at least one event is being counted
+    bool available() const;
+
+    // Zero and enable the counters
+    void start();
+    // Disable the counters and read them
+    PerfSample stop();
+
+    // Short name of an event, for reports
+    static const char* name(PerfEvent event);
+
+private:
+    PerfCounters(const PerfCounters&);
+    PerfCounters& operator=(const PerfCounters&);
+
+    int fds_[NUM_PERF_EVENTS];
+};
+
+#endif /* end of include guard: PERF_COUNTERS_HPP_ */
@@ -13,4 +13,9 @@ plot input_filename using 1:2 title "OPT", \
      input_filename using 1:4 title "FIFO", \
      input_filename using 1:5 title "RAND", \
      input_filename using 1:6 title "CLOCK", \
+     input_filename using 1:7 title "ARC", \
+     input_filename using 1:8 title "CAR", \
+     input_filename using 1:9 title "CLOCK-Pro", \
+     input_filename using 1:10 title "LIRS", \
+     input_filename using 1:11 title "W-TinyLFU", \
 
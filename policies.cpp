@@ -1,16 +1,62 @@
 #include <vector>
-#include <unordered_set>
-#include <unordered_map>
-#include <random>
-#include <ctime>
-#include <list>
 #include <algorithm>
+#include <limits>
 #include "policies.hpp"
 using std::vector;
-using std::uniform_int_distribution;
-using std::default_random_engine;
 
-static const int INVALID_PAGE = -1;
+// Marks empty frames, the largest page id is reserved for it
+template <typename PageId>
+static const PageId INVALID_PAGE = std::numeric_limits<PageId>::max();
+
+/*!
+ *  \brief Feed every access of a workload to a policy.
+ *
+ *  Templated on the concrete policy so that the calls to access() are not
+ *  virtual in the function pointer wrappers.
+ *
+ *  \param policy Policy to simulate
+ *  \param workload Vector of page accesses to evaluate
+ *  \return Number of cache hits of the policy so far
+ */
+template <class ConcretePolicy, typename PageId>
+static int replay(ConcretePolicy& policy, const vector<PageId>& workload) {
+    policy.access_batch(workload.data(), workload.size(), NULL);
+    return policy.stats().hits;
+}
+
+// How many accesses ahead the batch loops prefetch index entries
+static const size_t PREFETCH_DISTANCE = 8;
+
+/*!
+ *  \brief Tight access loop shared by the access_batch overrides.
+ *
+ *  Calls to access() and prefetch() are resolved statically because every
+ *  concrete policy is final.
+ */
+template <class ConcretePolicy, typename PageId>
+static size_t batch(ConcretePolicy& policy, const PageId* pages, size_t n, uint8_t* hit_out) {
+    size_t hits = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i + PREFETCH_DISTANCE < n) {
+            policy.prefetch(pages[i + PREFETCH_DISTANCE]);
+        }
+        bool hit = policy.access(pages[i]);
+        hits += hit;
+        if (hit_out) hit_out[i] = hit;
+    }
+    return hits;
+}
+
+template <typename PageId>
+size_t Policy<PageId>::access_batch(const PageId* pages, size_t n, uint8_t* hit_out) {
+    size_t hits = 0;
+    for (size_t i = 0; i < n; i++) {
+        bool hit = access(pages[i]);
+        hits += hit;
+        if (hit_out) hit_out[i] = hit;
+    }
+    return hits;
+}
 
 /*!
  *  \brief Calculate number of page hits when using FIFO page replacement policy.
@@ -18,224 +64,1547 @@ static const int INVALID_PAGE = -1;
  *  Calculates the number of page cache hits generated for a given sequence of
  *  page accesses when using the FIFO page replacement policy.
  *
- *  \param workload Vector of page accesses to evaluate
+ *  \param workload Page accesses to evaluate
 
  *  \param memsize Memory size, in pages
  *  \return Number of cache hits generated by using FIFO policy
  */
-int PRP_FIFO(const vector<int>& workload, unsigned int memsize) {
-    int hits = 0;
-    vector<int> cachedPages(memsize, INVALID_PAGE);
-    vector<int>::size_type cachedPagesHead = 0;
-
-    // Loop for each page access in workload
-    for (int access : workload) {
-        // Check if page being accessed is in the page cache
-        if (std::count(cachedPages.begin(), cachedPages.end(), access) > 0) {
-            // Page cache hit
-            hits++;
-        } else {
-            // Page cache miss
-            // Replace page at head of list with the one being accessed
-            cachedPages.at(cachedPagesHead) = access;
-            // Move head of list forward by one
-            cachedPagesHead = (cachedPagesHead + 1) % cachedPages.size();
-        }
+int PRP_FIFO(const DenseWorkload& workload, unsigned int memsize) {
+    FifoPolicy<uint32_t> policy(memsize, workload.universe);
+    return replay(policy, workload.pages());
+}
+
+template <typename PageId>
+int PRP_FIFO(const vector<PageId>& workload, unsigned int memsize) {
+    return PRP_FIFO(DenseWorkload(workload), memsize);
+}
+
+template <typename PageId>
+FifoPolicy<PageId>::FifoPolicy(unsigned int memsize, unsigned int universe)
+    : Policy<PageId>(memsize), frames_(memsize, INVALID_PAGE<PageId>), head_(0), index_(memsize, universe) {
+}
+
+template <typename PageId>
+bool FifoPolicy<PageId>::access(PageId page) {
+    // Check if page being accessed is in the page cache
+    if (index_.find(page) != SlotIndex<PageId>::NOT_FOUND) {
+        // Page cache hit
+        return this->record(true);
+    }
+    if (this->memsize_ == 0) {
+        return this->record(false);
     }
 
-    return hits;
+    // Page cache miss
+    // Replace page at head of list with the one being accessed
+    if (frames_[head_] != INVALID_PAGE<PageId>) {
+        index_.erase(frames_[head_]);
+    }
+    frames_[head_] = page;
+    index_.insert(page, head_);
+    // Move head of list forward by one
+    if (++head_ == this->memsize_) head_ = 0;
+    return this->record(false);
+}
+
+template <typename PageId>
+void FifoPolicy<PageId>::reset() {
+    std::fill(frames_.begin(), frames_.end(), INVALID_PAGE<PageId>);
+    head_ = 0;
+    index_.clear();
+    this->clearStats();
+}
+
+template <typename PageId>
+size_t FifoPolicy<PageId>::access_batch(const PageId* pages, size_t n, uint8_t* hit_out) {
+    return batch(*this, pages, n, hit_out);
+}
+
+template <typename PageId>
+void FifoPolicy<PageId>::prefetch(PageId page) const {
+    index_.prefetch(page);
+}
+
+// Marks pages not accessed yet in the flat per-page tables of the hit curves
+static const size_t NOT_SEEN = static_cast<size_t>(-1);
+
+/*!
+ *  \brief Compute the time of the next use of every access in a workload.
+ *
+ *  Element i is the time of the next access to workload[i] after time i. Pages
+ *  that are never used again get the unique key workload.size() + i, so keys
+ *  never tie and all compare after every real access.
+ *
+ *  \param dense Page accesses to evaluate
+ *  \return Vector of next use times, one per access
+ */
+static vector<size_t> next_uses(const DenseWorkload& dense) {
+    const vector<uint32_t>& workload = dense.pages();
+    const size_t length = workload.size();
+    vector<size_t> nextUse(length);
+    // Key: page Value: earliest time seen so far while walking backwards
+    vector<size_t> seen(dense.universe, NOT_SEEN);
+    for (size_t time = length; time-- > 0;) {
+        size_t& found = seen[workload[time]];
+        nextUse[time] = found != NOT_SEEN ? found : length + time;
+        found = time;
+    }
+    return nextUse;
 }
 
 /*!
  *  \brief Calculate number of page hits when using optimal page replacement policy.
  *
  *  Calculates the number of page cache hits generated for a given sequence of
- *  page accesses when using the optimal page replacement policy.
+ *  page accesses when using the optimal page replacement policy, by announcing
+ *  the whole workload to an OptPolicy before replaying it.
  *
- *  \param workload Vector of page accesses to evaluate
+ *  \param workload Page accesses to evaluate
  *	\param memsize Size of physical memory to work with (in pages)
  *
- *  \return Number of cache hits generated by using random policy
+ *  \return Number of cache hits generated by using optimal policy
  */
-unsigned long list_hash(const std::list<unsigned int>& q){
-	return (unsigned long)(&q);
-}
-int PRP_OPT(const vector<int>& workload, unsigned int memsize){
-	std::unordered_set<int> pages_in_mem;
-	std::unordered_map<int, std::list<unsigned int>> accesses; //Key: page Value: list of every access for a page
-	int hits = 0;
-	unsigned int j = 0;
-	for(;j < workload.size(); j++){
-		if(accesses.count(workload[j] > 0)) (accesses[workload[j]]).push_back(j);
-		else{
-			accesses[workload[j]] = std::list<unsigned int>();
-			(accesses[workload[j]]).push_back(j);
-		}
-	}
+int PRP_OPT(const DenseWorkload& workload, unsigned int memsize) {
+    OptPolicy<uint32_t> policy(memsize, workload.universe);
+    for (uint32_t access : workload.pages()) {
+        policy.lookahead(access);
+    }
+    return replay(policy, workload.pages());
+}
 
-	for(unsigned int i = 0; i < workload.size(); i++){
-		if((accesses[workload[i]]).size() > 0) accesses[workload[i]].pop_front();
-		if(pages_in_mem.count(workload[i]) > 0){
-			hits++;
-		} 
-		else if(pages_in_mem.size() < memsize){
-			pages_in_mem.insert(workload[i]);
-		}
-		else {
-			int latest = *pages_in_mem.begin();
-			for(int page : pages_in_mem){
-				if(accesses[page].size() == 0){
-					latest = page;
-					break;
-				} else if(accesses[page].front() > accesses[latest].front()){
-					latest = page;
-				}			
-			}
-			pages_in_mem.erase(latest);
-			pages_in_mem.insert(workload[i]);
-		}
-	}
-	return hits;
+template <typename PageId>
+int PRP_OPT(const vector<PageId>& workload, unsigned int memsize) {
+    return PRP_OPT(DenseWorkload(workload), memsize);
+}
+
+// Keys of pages with no announced next use count down from here, past any real time
+static const uint64_t NEVER_USED = ~0ULL;
+
+/*
+ * Every access gets a unique key: the time of its next announced use, or
+ * NEVER_USED minus its own time, so that among pages with no announced use the
+ * least recently used one is evicted first. A heap entry goes stale when its
+ * frame is given a new key, which happens on a hit, when a later use is
+ * announced, or when the frame is reused; stale entries are skipped when popped
+ * and dropped whenever the heap grows past twice the memory size.
+ */
+template <typename PageId>
+OptPolicy<PageId>::OptPolicy(unsigned int memsize, unsigned int universe)
+    : Policy<PageId>(memsize), time_(0), horizon_(0), lastAnnounced_(universe > 0 ? 0 : memsize),
+      lastAnnouncedDense_(universe, NEVER_USED),
+      dense_(universe > 0), index_(memsize, universe) {
+    framePage_.reserve(memsize);
+    frameKey_.reserve(memsize);
+    heap_.reserve(2 * static_cast<size_t>(memsize) + 2);
+}
+
+template <typename PageId>
+void OptPolicy<PageId>::lookahead(PageId page) {
+    const uint64_t time = horizon_++;
+    nextUse_.push_back(NEVER_USED - time);
+
+    uint64_t* found = announced(page);
+    if (!found) {
+        setAnnounced(page, time);
+        return;
+    }
+    const uint64_t previous = *found;
+    *found = time;
+    if (previous >= time_) {
+        // Previous use is still in the window
+        nextUse_[previous - time_] = time;
+    } else {
+        // Previous use already happened, so the page is resident with no known next use
+        unsigned int frame = index_.find(page);
+        if (frame != SlotIndex<PageId>::NOT_FOUND) {
+            frameKey_[frame] = time;
+            push(time, frame);
+        }
+    }
+}
+
+template <typename PageId>
+bool OptPolicy<PageId>::access(PageId page) {
+    if (time_ == horizon_) {
+        lookahead(page);
+    }
+    const uint64_t key = nextUse_.front();
+    nextUse_.pop_front();
+    time_++;
+
+    unsigned int frame = index_.find(page);
+    if (frame != SlotIndex<PageId>::NOT_FOUND) {
+        // Page cache hit, its old heap entry is now stale
+        frameKey_[frame] = key;
+        push(key, frame);
+        return this->record(true);
+    }
+
+    if (this->memsize_ == 0) {
+        if (*announced(page) < time_) forgetAnnounced(page);
+        return this->record(false);
+    }
+
+    if (framePage_.size() < this->memsize_) {
+        frame = framePage_.size();
+        framePage_.push_back(page);
+        frameKey_.push_back(key);
+    } else {
+        // Evict the page used furthest in the future
+        for (;;) {
+            std::pop_heap(heap_.begin(), heap_.end());
+            const std::pair<uint64_t, unsigned int> top = heap_.back();
+            heap_.pop_back();
+            if (frameKey_[top.second] == top.first) {
+                frame = top.second;
+                break;
+            }
+        }
+        const PageId victim = framePage_[frame];
+        index_.erase(victim);
+        if (*announced(victim) < time_) forgetAnnounced(victim);
+        framePage_[frame] = page;
+        frameKey_[frame] = key;
+    }
+    index_.insert(page, frame);
+    push(key, frame);
+    return this->record(false);
+}
+
+template <typename PageId>
+void OptPolicy<PageId>::reset() {
+    time_ = 0;
+    horizon_ = 0;
+    nextUse_.clear();
+    lastAnnounced_.clear();
+    std::fill(lastAnnouncedDense_.begin(), lastAnnouncedDense_.end(), NEVER_USED);
+    framePage_.clear();
+    frameKey_.clear();
+    index_.clear();
+    heap_.clear();
+    this->clearStats();
+}
+
+template <typename PageId>
+size_t OptPolicy<PageId>::access_batch(const PageId* pages, size_t n, uint8_t* hit_out) {
+    return batch(*this, pages, n, hit_out);
+}
+
+template <typename PageId>
+void OptPolicy<PageId>::prefetch(PageId page) const {
+    index_.prefetch(page);
+}
+
+template <typename PageId>
+void OptPolicy<PageId>::push(uint64_t key, unsigned int frame) {
+    heap_.emplace_back(key, frame);
+    std::push_heap(heap_.begin(), heap_.end());
+    if (heap_.size() > 2 * static_cast<size_t>(this->memsize_) + 1) {
+        compact();
+    }
+}
+
+template <typename PageId>
+uint64_t* OptPolicy<PageId>::announced(PageId page) {
+    if (dense_) {
+        return lastAnnouncedDense_[page] != NEVER_USED ? &lastAnnouncedDense_[page] : NULL;
+    }
+    return lastAnnounced_.find(page);
+}
+
+template <typename PageId>
+void OptPolicy<PageId>::setAnnounced(PageId page, uint64_t time) {
+    if (dense_) lastAnnouncedDense_[page] = time;
+    else lastAnnounced_[page] = time;
+}
+
+template <typename PageId>
+void OptPolicy<PageId>::forgetAnnounced(PageId page) {
+    if (dense_) lastAnnouncedDense_[page] = NEVER_USED;
+    else lastAnnounced_.erase(page);
+}
+
+template <typename PageId>
+void OptPolicy<PageId>::compact() {
+    heap_.clear();
+    for (unsigned int frame = 0; frame < framePage_.size(); frame++) {
+        heap_.emplace_back(frameKey_[frame], frame);
+    }
+    std::make_heap(heap_.begin(), heap_.end());
+}
+
+/*!
+ *  \brief Calculate number of optimal policy page hits for every memory size at once.
+ *
+ *  The optimal policy is a stack algorithm when pages are prioritised by their
+ *  next use, so this maintains Mattson's priority stack: the accessed page goes
+ *  to the top and the displaced entries trickle down, each level keeping the
+ *  entry used sooner and passing the other one on, until the old position of
+ *  the accessed page is reached. An access found at depth d hits in every memory
+ *  of more than d pages. Only the top max_memsize levels are kept, so each access
+ *  costs O(max_memsize) and the whole curve costs a single pass.
+ *
+ *  \param dense Page accesses to evaluate
+ *  \param max_memsize Largest memory size, in pages, to report
+ *  \return Vector of max_memsize + 1 hit counts, indexed by memory size
+ */
+vector<int> OPT_hit_curve(const DenseWorkload& dense, unsigned int max_memsize) {
+    const vector<size_t> nextUse = next_uses(dense);
+    const vector<uint32_t>& workload = dense.pages();
+    // Next use of the page at each stack level, top first. The page accessed at
+    // time t is the one whose entry is keyed t.
+    vector<size_t> stack;
+    stack.reserve(max_memsize);
+    // distances[d] counts accesses found at stack depth d - 1
+    vector<int> distances(max_memsize + 1, 0);
+
+    for (size_t time = 0; time < workload.size(); time++) {
+        // The accessed page always moves to the top
+        size_t carry = nextUse[time];
+        size_t level = 0;
+        if (!stack.empty() && stack[0] != time) {
+            std::swap(carry, stack[0]);
+            level = 1;
+        }
+        for (; level < stack.size(); level++) {
+            if (stack[level] == time) {
+                // Found the accessed page, its slot takes the displaced entry
+                stack[level] = carry;
+                distances[level + 1]++;
+                break;
+            }
+            if (carry < stack[level]) {
+                std::swap(carry, stack[level]);
+            }
+        }
+        if (level == stack.size() && stack.size() < max_memsize) {
+            stack.push_back(carry);
+        }
+    }
+
+    vector<int> hits(max_memsize + 1, 0);
+    for (unsigned int memsize = 1; memsize <= max_memsize; memsize++) {
+        hits[memsize] = hits[memsize - 1] + distances[memsize];
+    }
+    return hits;
+}
+
+template <typename PageId>
+vector<int> OPT_hit_curve(const vector<PageId>& workload, unsigned int max_memsize) {
+    return OPT_hit_curve(DenseWorkload(workload), max_memsize);
 }
 
 /*!
  *  \brief Calculate number of page hits when using random page replacement policy.
  *
  *  Calculates the number of page cache hits generated for a given sequence of
- *  page accesses when using the random page replacement policy.
+ *  page accesses when using the random page replacement policy. Uses a fixed
+ *  seed, so repeated runs give the same result.
  *
- *  \param workload Vector of page accesses to evaluate
+ *  \param workload Page accesses to evaluate
  *	\param memsize Size of physical memory to work with (in pages)
  *
  *  \return Number of cache hits generated by using random policy
  */
-int PRP_RAND(const vector<int>& workload, unsigned int memsize){
-	vector<int> pages_in_mem;
-	default_random_engine random_engine;
-	random_engine.seed(std::time(NULL));
-	int hits = 0;
-	for(unsigned int i = 0; i < workload.size(); i++){
-		bool found = false;
-		for(unsigned int j = 0; j < pages_in_mem.size(); j++){
-			if(pages_in_mem[j] == workload[i]){
-				hits++;
-				found = true;
-				break;
-			}
-		}
-		if(!found){
-			if(pages_in_mem.size() < memsize){
-				pages_in_mem.push_back(workload[i]);
-			}
-			else {
-				uniform_int_distribution<int> gen(0 , pages_in_mem.size() - 1);
-				unsigned int index = gen(random_engine);
-				pages_in_mem[index] = workload[i];
-			}
-		}
+int PRP_RAND(const DenseWorkload& workload, unsigned int memsize){
+	return PRP_RAND_seeded(workload, memsize, RAND_DEFAULT_SEED);
+}
+
+template <typename PageId>
+int PRP_RAND(const vector<PageId>& workload, unsigned int memsize){
+	return PRP_RAND(DenseWorkload(workload), memsize);
+}
+
+/*!
+ *  \brief Calculate number of page hits when using random page replacement policy.
+ *
+ *  \param workload Page accesses to evaluate
+ *	\param memsize Size of physical memory to work with (in pages)
+ *	\param seed Seed for the victim selection generator
+ *
+ *  \return Number of cache hits generated by using random policy
+ */
+int PRP_RAND_seeded(const DenseWorkload& workload, unsigned int memsize, uint64_t seed){
+	return PRP_RAND_seeds(workload, memsize, vector<uint64_t>(1, seed))[0];
+}
+
+template <typename PageId>
+int PRP_RAND_seeded(const vector<PageId>& workload, unsigned int memsize, uint64_t seed){
+	return PRP_RAND_seeded(DenseWorkload(workload), memsize, seed);
+}
 
+/*!
+ *  \brief Calculate page hits of the random policy for several seeds in one pass.
+ *
+ *  Simulates one independent random cache per seed while walking the workload
+ *  once, so the spread of hit counts over seeds (and so a confidence interval)
+ *  costs a single trace replay. Each cache indexes its frames with a hash table
+ *  and picks victims with xoshiro256**, so every access is O(1) per seed.
+ *
+ *  \param workload Page accesses to evaluate
+ *	\param memsize Size of physical memory to work with (in pages)
+ *	\param seeds Seeds for the victim selection generators, one per cache
+ *
+ *  \return Number of cache hits for each seed, in the order of seeds
+ */
+vector<int> PRP_RAND_seeds(const DenseWorkload& workload, unsigned int memsize, const vector<uint64_t>& seeds){
+	vector<RandPolicy<uint32_t>> caches;
+	caches.reserve(seeds.size());
+	for(uint64_t seed : seeds){
+		caches.emplace_back(memsize, seed, workload.universe);
+	}
+	for(uint32_t access : workload.pages()){
+		for(RandPolicy<uint32_t>& cache : caches){
+			cache.access(access);
+		}
+	}
+	vector<int> hits;
+	for(const RandPolicy<uint32_t>& cache : caches){
+		hits.push_back(cache.stats().hits);
 	}
 	return hits;
 }
 
+template <typename PageId>
+vector<int> PRP_RAND_seeds(const vector<PageId>& workload, unsigned int memsize, const vector<uint64_t>& seeds){
+	return PRP_RAND_seeds(DenseWorkload(workload), memsize, seeds);
+}
+
+template <typename PageId>
+RandPolicy<PageId>::RandPolicy(unsigned int memsize, uint64_t seed, unsigned int universe)
+	: Policy<PageId>(memsize), seed_(seed), index_(memsize, universe), random_engine_(seed) {
+	frames_.reserve(memsize);
+}
+
+template <typename PageId>
+bool RandPolicy<PageId>::access(PageId page){
+	if(index_.find(page) != SlotIndex<PageId>::NOT_FOUND){
+		return this->record(true);
+	}
+	if(frames_.size() < this->memsize_){
+		index_.insert(page, frames_.size());
+		frames_.push_back(page);
+	}
+	else if(this->memsize_ > 0){
+		unsigned int victim = random_engine_.below(this->memsize_);
+		index_.erase(frames_[victim]);
+		index_.insert(page, victim);
+		frames_[victim] = page;
+	}
+	return this->record(false);
+}
+
+template <typename PageId>
+void RandPolicy<PageId>::reset(){
+	frames_.clear();
+	index_.clear();
+	random_engine_ = Xoshiro256(seed_);
+	this->clearStats();
+}
+
+template <typename PageId>
+size_t RandPolicy<PageId>::access_batch(const PageId* pages, size_t n, uint8_t* hit_out){
+	return batch(*this, pages, n, hit_out);
+}
+
+template <typename PageId>
+void RandPolicy<PageId>::prefetch(PageId page) const {
+	index_.prefetch(page);
+}
+
 /*!
  *  \brief Calculate number of page hits when using LRU page replacement policy.
  *
  *  Calculates the number of page cache hits generated for a given sequence of
  *  page accesses when using the Least Recently Used page replacement policy.
  *
- *  \param workload Vector of page accesses to evaluate
+ *  \param workload Page accesses to evaluate
  *  \param memsize Memory size, in pages
  *  \return Number of cache hits generated by using LRU policy
  */
-int PRP_LRU(const vector<int>& workload, unsigned int memsize) {
-    std::unordered_map<int, unsigned int> cache;
-    unsigned int hits = 0;
-
-    for (unsigned int time = 0; time < workload.size(); time++) {
-        int access = workload[time];
-
-        if (cache.count(access) == 0) {
-            // Cache miss
-            cache.emplace(access, time);
-
-            // Should only ever loop once, but use while just in case
-            while (cache.size() > memsize) {
-                // Find least recently used entry and evict it from cache
-                auto oldestEntry = cache.begin();
-                for (auto iter = ++(cache.begin()); iter != cache.end(); iter++) {
-                    if (iter->second < oldestEntry->second) {
-                        oldestEntry = iter;
-                    }
-                }
-                cache.erase(oldestEntry);
-            }
-        } else {
-            // Cache hit
-            hits++;
-            cache.at(access) = time;
+int PRP_LRU(const DenseWorkload& workload, unsigned int memsize) {
+    LruPolicy<uint32_t> policy(memsize, workload.universe);
+    return replay(policy, workload.pages());
+}
+
+template <typename PageId>
+int PRP_LRU(const vector<PageId>& workload, unsigned int memsize) {
+    return PRP_LRU(DenseWorkload(workload), memsize);
+}
+
+// Frames are threaded through prev/next by index; head is the most recently
+// used frame and tail the least recently used one.
+static const unsigned int NIL = static_cast<unsigned int>(-1);
+
+template <typename PageId>
+LruPolicy<PageId>::LruPolicy(unsigned int memsize, unsigned int universe)
+    : Policy<PageId>(memsize), framePage_(memsize, INVALID_PAGE<PageId>), prev_(memsize, NIL),
+      next_(memsize, NIL), head_(NIL), tail_(NIL), used_(0), index_(memsize, universe) {
+}
+
+template <typename PageId>
+bool LruPolicy<PageId>::access(PageId page) {
+    unsigned int found = index_.find(page);
+    if (found != SlotIndex<PageId>::NOT_FOUND) {
+        // Cache hit, move frame to the front of the recency list
+        if (found != head_) {
+            unlink(found);
+            pushFront(found);
         }
+        return this->record(true);
+    }
+    if (this->memsize_ == 0) {
+        return this->record(false);
+    }
+
+    // Cache miss
+    unsigned int frame;
+    if (used_ < this->memsize_) {
+        // Cache can fit another page
+        frame = used_++;
+    } else {
+        // Evict least recently used page at the tail of the list
+        frame = tail_;
+        unlink(frame);
+        index_.erase(framePage_[frame]);
     }
+    framePage_[frame] = page;
+    index_.insert(page, frame);
+    pushFront(frame);
+    return this->record(false);
+}
+
+template <typename PageId>
+void LruPolicy<PageId>::reset() {
+    head_ = NIL;
+    tail_ = NIL;
+    used_ = 0;
+    index_.clear();
+    this->clearStats();
+}
 
+template <typename PageId>
+size_t LruPolicy<PageId>::access_batch(const PageId* pages, size_t n, uint8_t* hit_out) {
+    return batch(*this, pages, n, hit_out);
+}
+
+template <typename PageId>
+void LruPolicy<PageId>::prefetch(PageId page) const {
+    index_.prefetch(page);
+}
+
+template <typename PageId>
+void LruPolicy<PageId>::unlink(unsigned int frame) {
+    if (prev_[frame] != NIL) next_[prev_[frame]] = next_[frame];
+    else head_ = next_[frame];
+    if (next_[frame] != NIL) prev_[next_[frame]] = prev_[frame];
+    else tail_ = prev_[frame];
+}
+
+template <typename PageId>
+void LruPolicy<PageId>::pushFront(unsigned int frame) {
+    prev_[frame] = NIL;
+    next_[frame] = head_;
+    if (head_ != NIL) prev_[head_] = frame;
+    head_ = frame;
+    if (tail_ == NIL) tail_ = frame;
+}
+
+/*!
+ *  \brief Calculate number of LRU page hits for every memory size at once.
+ *
+ *  LRU is a stack algorithm, so an access hits in a memory of m pages exactly
+ *  when its reuse (stack) distance is at most m. The stack distance of an access
+ *  is the number of distinct pages touched since the previous access to the same
+ *  page, which is counted with a Fenwick tree holding a marker at the time of
+ *  the latest access of every page. Each access costs O(log n).
+ *
+ *  \param dense Page accesses to evaluate
+ *  \param max_memsize Largest memory size, in pages, to report
+ *  \return Vector of max_memsize + 1 hit counts, indexed by memory size
+ */
+vector<int> LRU_hit_curve(const DenseWorkload& dense, unsigned int max_memsize) {
+    const vector<uint32_t>& workload = dense.pages();
+    // 1-based Fenwick tree over access times
+    vector<int> tree(workload.size() + 1, 0);
+    auto add = [&tree](size_t pos, int delta) {
+        for (; pos < tree.size(); pos += pos & (~pos + 1)) tree[pos] += delta;
+    };
+    auto prefix = [&tree](size_t pos) {
+        int sum = 0;
+        for (; pos > 0; pos -= pos & (~pos + 1)) sum += tree[pos];
+        return sum;
+    };
+
+    // Key: page Value: 1-based time of the latest access to that page
+    vector<size_t> lastAccess(dense.universe, NOT_SEEN);
+    // distances[d] counts accesses with stack distance d (d <= max_memsize)
+    vector<int> distances(max_memsize + 1, 0);
+
+    for (size_t time = 1; time <= workload.size(); time++) {
+        size_t& previous = lastAccess[workload[time - 1]];
+        if (previous != NOT_SEEN) {
+            // Distinct pages touched strictly after the previous access, plus itself
+            unsigned int distance = prefix(time - 1) - prefix(previous) + 1;
+            if (distance <= max_memsize) distances[distance]++;
+            add(previous, -1);
+        }
+        previous = time;
+        add(time, 1);
+    }
+
+    // An access with distance d hits in every memory of at least d pages
+    vector<int> hits(max_memsize + 1, 0);
+    for (unsigned int memsize = 1; memsize <= max_memsize; memsize++) {
+        hits[memsize] = hits[memsize - 1] + distances[memsize];
+    }
     return hits;
 }
 
+template <typename PageId>
+vector<int> LRU_hit_curve(const vector<PageId>& workload, unsigned int max_memsize) {
+    return LRU_hit_curve(DenseWorkload(workload), max_memsize);
+}
+
 /*!
  *  \brief Calculate number of page hits when using the Clock page replacement policy.
  *
  *  Calculates the number of page cache hits generated for a given sequence of
  *  page accesses when using the Clock page replacement policy.
  *
- *  \param workload Vector of page accesses to evaluate
+ *  The clock hand persists between evictions, so each sweep resumes where the
+ *  last victim was taken, and the frame index makes hits O(1).
+ *
+ *  \param workload Page accesses to evaluate
  *  \param memsize Memory size, in pages
  *  \return Number of cache hits generated by using Clock policy
  */
-int PRP_CLOCK(const vector<int>& workload, unsigned int memsize) {
-    // first: accessed page, second: use bit
-    typedef std::pair<int, bool> ClockEntry;
-    typedef vector<ClockEntry> Clock;
+int PRP_CLOCK(const DenseWorkload& workload, unsigned int memsize) {
+    ClockPolicy<uint32_t> policy(memsize, workload.universe);
+    return replay(policy, workload.pages());
+}
+
+template <typename PageId>
+int PRP_CLOCK(const vector<PageId>& workload, unsigned int memsize) {
+    return PRP_CLOCK(DenseWorkload(workload), memsize);
+}
+
+template <typename PageId>
+ClockPolicy<PageId>::ClockPolicy(unsigned int memsize, unsigned int universe)
+    : Policy<PageId>(memsize), clockHand_(0), index_(memsize, universe) {
+    framePage_.reserve(memsize);
+    useBit_.reserve(memsize);
+}
+
+template <typename PageId>
+bool ClockPolicy<PageId>::access(PageId page) {
+    unsigned int frame = index_.find(page);
+    if (frame != SlotIndex<PageId>::NOT_FOUND) {
+        // Cache hit
+        useBit_[frame] = true;
+        return this->record(true);
+    }
+
+    if (framePage_.size() < this->memsize_) {
+        // Cache can fit another page
+        index_.insert(page, framePage_.size());
+        framePage_.push_back(page);
+        useBit_.push_back(true);
+    } else if (this->memsize_ > 0) {
+        // Sweep from where the hand last stopped, giving used pages a second chance
+        while (useBit_[clockHand_]) {
+            useBit_[clockHand_] = false;
+            if (++clockHand_ == this->memsize_) clockHand_ = 0;
+        }
+
+        // Replace victim page in cache with page we are now accessing
+        index_.erase(framePage_[clockHand_]);
+        index_.insert(page, clockHand_);
+        framePage_[clockHand_] = page;
+        useBit_[clockHand_] = true;
+        if (++clockHand_ == this->memsize_) clockHand_ = 0;
+    }
+    return this->record(false);
+}
+
+template <typename PageId>
+void ClockPolicy<PageId>::reset() {
+    framePage_.clear();
+    useBit_.clear();
+    clockHand_ = 0;
+    index_.clear();
+    this->clearStats();
+}
+
+template <typename PageId>
+size_t ClockPolicy<PageId>::access_batch(const PageId* pages, size_t n, uint8_t* hit_out) {
+    return batch(*this, pages, n, hit_out);
+}
+
+template <typename PageId>
+void ClockPolicy<PageId>::prefetch(PageId page) const {
+    index_.prefetch(page);
+}
+
+EntryLists::EntryLists(size_t entries, unsigned int lists)
+    : prev_(entries, static_cast<unsigned int>(NIL)), next_(entries, static_cast<unsigned int>(NIL)),
+      list_(entries, static_cast<unsigned char>(UNLINKED)), head_(lists, static_cast<unsigned int>(NIL)),
+      tail_(lists, static_cast<unsigned int>(NIL)), size_(lists, 0) {
+    free_.reserve(entries);
+    clear();
+}
+
+void EntryLists::clear() {
+    for (size_t list = 0; list < head_.size(); list++) {
+        head_[list] = NIL;
+        tail_[list] = NIL;
+        size_[list] = 0;
+    }
+    std::fill(list_.begin(), list_.end(), static_cast<unsigned char>(UNLINKED));
+    // Hand entries out lowest index first
+    free_.clear();
+    for (size_t entry = prev_.size(); entry-- > 0;) {
+        free_.push_back(entry);
+    }
+}
+
+unsigned int EntryLists::allocate() {
+    const unsigned int entry = free_.back();
+    free_.pop_back();
+    return entry;
+}
+
+void EntryLists::release(unsigned int entry) {
+    free_.push_back(entry);
+}
+
+void EntryLists::pushFront(unsigned int list, unsigned int entry) {
+    list_[entry] = list;
+    prev_[entry] = NIL;
+    next_[entry] = head_[list];
+    if (head_[list] != NIL) prev_[head_[list]] = entry;
+    else tail_[list] = entry;
+    head_[list] = entry;
+    size_[list]++;
+}
+
+void EntryLists::pushBack(unsigned int list, unsigned int entry) {
+    list_[entry] = list;
+    next_[entry] = NIL;
+    prev_[entry] = tail_[list];
+    if (tail_[list] != NIL) next_[tail_[list]] = entry;
+    else head_[list] = entry;
+    tail_[list] = entry;
+    size_[list]++;
+}
+
+void EntryLists::unlink(unsigned int entry) {
+    const unsigned int list = list_[entry];
+    if (prev_[entry] != NIL) next_[prev_[entry]] = next_[entry];
+    else head_[list] = next_[entry];
+    if (next_[entry] != NIL) prev_[next_[entry]] = prev_[entry];
+    else tail_[list] = prev_[entry];
+    list_[entry] = UNLINKED;
+    size_[list]--;
+}
+
+/*!
+ *  \brief Calculate number of page hits when using the ARC page replacement policy.
+ *
+ *  Calculates the number of page cache hits generated for a given sequence of
+ *  page accesses when using the Adaptive Replacement Cache policy.
+ *
+ *  \param workload Page accesses to evaluate
+ *  \param memsize Memory size, in pages
+ *  \return Number of cache hits generated by using ARC policy
+ */
+int PRP_ARC(const DenseWorkload& workload, unsigned int memsize) {
+    ArcPolicy<uint32_t> policy(memsize, workload.universe);
+    return replay(policy, workload.pages());
+}
 
-    int hits = 0;
+template <typename PageId>
+int PRP_ARC(const vector<PageId>& workload, unsigned int memsize) {
+    return PRP_ARC(DenseWorkload(workload), memsize);
+}
+
+/*
+ * The head of each list is its most recently used entry. Entries of T1 and T2
+ * hold resident pages, entries of B1 and B2 only remember evicted ones; the
+ * index covers all four, so a ghost hit is found as cheaply as a real one.
+ */
+template <typename PageId>
+ArcPolicy<PageId>::ArcPolicy(unsigned int memsize, unsigned int universe)
+    : Policy<PageId>(memsize), lists_(2 * static_cast<size_t>(memsize), NUM_LISTS),
+      entryPage_(2 * static_cast<size_t>(memsize), INVALID_PAGE<PageId>), target_(0),
+      index_(2 * memsize, universe) {
+}
 
-    Clock cache;
-    for (auto access : workload) {
-        // Find page in cache if it is already there
-        Clock::iterator iter = std::find_if(cache.begin(), cache.end(),
-            [access](const ClockEntry& elem) {
-                return elem.first == access;
+template <typename PageId>
+bool ArcPolicy<PageId>::access(PageId page) {
+    const unsigned int capacity = this->memsize_;
+    unsigned int entry = index_.find(page);
+    if (entry != SlotIndex<PageId>::NOT_FOUND) {
+        const List list = static_cast<List>(lists_.listOf(entry));
+        if (list == T1 || list == T2) {
+            // Cache hit, the page has now been seen twice
+            if (entry != lists_.front(T2)) {
+                lists_.unlink(entry);
+                lists_.pushFront(T2, entry);
             }
-        );
+            return this->record(true);
+        }
+        // Ghost hit: the list the page was evicted from should have been larger
+        if (list == B1) {
+            target_ = std::min(capacity, target_ + std::max(lists_.size(B2) / lists_.size(B1), 1u));
+        } else {
+            target_ -= std::min(target_, std::max(lists_.size(B1) / lists_.size(B2), 1u));
+        }
+        replace(list == B2);
+        lists_.unlink(entry);
+        lists_.pushFront(T2, entry);
+        return this->record(false);
+    }
+    if (capacity == 0) {
+        return this->record(false);
+    }
+
+    // Complete miss, keep |T1| + |B1| <= c and the four lists within 2c
+    const unsigned int t1 = lists_.size(T1);
+    const unsigned int b1 = lists_.size(B1);
+    const unsigned int total = t1 + b1 + lists_.size(T2) + lists_.size(B2);
+    if (t1 + b1 == capacity) {
+        if (t1 < capacity) {
+            drop(B1);
+            replace(false);
+        } else {
+            drop(T1);
+        }
+    } else if (total >= capacity) {
+        if (total == 2 * capacity) {
+            drop(B2);
+        }
+        replace(false);
+    }
+    entry = lists_.allocate();
+    entryPage_[entry] = page;
+    index_.insert(page, entry);
+    lists_.pushFront(T1, entry);
+    return this->record(false);
+}
+
+template <typename PageId>
+void ArcPolicy<PageId>::reset() {
+    lists_.clear();
+    target_ = 0;
+    index_.clear();
+    this->clearStats();
+}
+
+template <typename PageId>
+size_t ArcPolicy<PageId>::access_batch(const PageId* pages, size_t n, uint8_t* hit_out) {
+    return batch(*this, pages, n, hit_out);
+}
+
+template <typename PageId>
+void ArcPolicy<PageId>::prefetch(PageId page) const {
+    index_.prefetch(page);
+}
+
+template <typename PageId>
+void ArcPolicy<PageId>::replace(bool inB2) {
+    const unsigned int t1 = lists_.size(T1);
+    if (t1 > 0 && (t1 > target_ || (inB2 && t1 == target_) || lists_.size(T2) == 0)) {
+        demote(T1, B1);
+    } else {
+        demote(T2, B2);
+    }
+}
+
+template <typename PageId>
+void ArcPolicy<PageId>::demote(List from, List to) {
+    const unsigned int entry = lists_.back(from);
+    lists_.unlink(entry);
+    lists_.pushFront(to, entry);
+}
+
+template <typename PageId>
+void ArcPolicy<PageId>::drop(List list) {
+    const unsigned int entry = lists_.back(list);
+    lists_.unlink(entry);
+    index_.erase(entryPage_[entry]);
+    lists_.release(entry);
+}
+
+/*!
+ *  \brief Calculate number of page hits when using the CAR page replacement policy.
+ *
+ *  Calculates the number of page cache hits generated for a given sequence of
+ *  page accesses when using the Clock with Adaptive Replacement policy.
+ *
+ *  \param workload Page accesses to evaluate
+ *  \param memsize Memory size, in pages
+ *  \return Number of cache hits generated by using CAR policy
+ */
+int PRP_CAR(const DenseWorkload& workload, unsigned int memsize) {
+    CarPolicy<uint32_t> policy(memsize, workload.universe);
+    return replay(policy, workload.pages());
+}
+
+template <typename PageId>
+int PRP_CAR(const vector<PageId>& workload, unsigned int memsize) {
+    return PRP_CAR(DenseWorkload(workload), memsize);
+}
+
+template <typename PageId>
+CarPolicy<PageId>::CarPolicy(unsigned int memsize, unsigned int universe)
+    : Policy<PageId>(memsize), lists_(2 * static_cast<size_t>(memsize), NUM_LISTS),
+      entryPage_(2 * static_cast<size_t>(memsize), INVALID_PAGE<PageId>),
+      refBit_(2 * static_cast<size_t>(memsize), false), target_(0), index_(2 * memsize, universe) {
+}
+
+template <typename PageId>
+bool CarPolicy<PageId>::access(PageId page) {
+    const unsigned int capacity = this->memsize_;
+    unsigned int entry = index_.find(page);
+    List ghost = NUM_LISTS;
+    if (entry != SlotIndex<PageId>::NOT_FOUND) {
+        ghost = static_cast<List>(lists_.listOf(entry));
+        if (ghost == T1 || ghost == T2) {
+            // Cache hit, leave the page where it is for the hands to find
+            refBit_[entry] = true;
+            return this->record(true);
+        }
+    } else if (capacity == 0) {
+        return this->record(false);
+    }
+
+    if (lists_.size(T1) + lists_.size(T2) == capacity) {
+        replace();
+        // Keep |T1| + |B1| <= c and the four lists within 2c
+        if (ghost == NUM_LISTS) {
+            unsigned int victim = EntryLists::NIL;
+            if (lists_.size(T1) + lists_.size(B1) == capacity) {
+                victim = lists_.back(B1);
+            } else if (lists_.size(T1) + lists_.size(T2) + lists_.size(B1) + lists_.size(B2) == 2 * capacity) {
+                victim = lists_.back(B2);
+            }
+            if (victim != EntryLists::NIL) {
+                lists_.unlink(victim);
+                index_.erase(entryPage_[victim]);
+                lists_.release(victim);
+            }
+        }
+    }
+
+    if (ghost == NUM_LISTS) {
+        entry = lists_.allocate();
+        entryPage_[entry] = page;
+        index_.insert(page, entry);
+        lists_.pushBack(T1, entry);
+    } else {
+        // Ghost hit: the clock the page was evicted from should have been larger
+        if (ghost == B1) {
+            target_ = std::min(capacity, target_ + std::max(lists_.size(B2) / lists_.size(B1), 1u));
+        } else {
+            target_ -= std::min(target_, std::max(lists_.size(B1) / lists_.size(B2), 1u));
+        }
+        lists_.unlink(entry);
+        lists_.pushBack(T2, entry);
+    }
+    refBit_[entry] = false;
+    return this->record(false);
+}
+
+template <typename PageId>
+void CarPolicy<PageId>::reset() {
+    lists_.clear();
+    target_ = 0;
+    index_.clear();
+    this->clearStats();
+}
+
+template <typename PageId>
+size_t CarPolicy<PageId>::access_batch(const PageId* pages, size_t n, uint8_t* hit_out) {
+    return batch(*this, pages, n, hit_out);
+}
+
+template <typename PageId>
+void CarPolicy<PageId>::prefetch(PageId page) const {
+    index_.prefetch(page);
+}
+
+template <typename PageId>
+void CarPolicy<PageId>::replace() {
+    for (;;) {
+        // T2 is never empty when T1 is below target, since |T1| + |T2| = c >= target
+        const bool fromT1 = lists_.size(T1) >= std::max(target_, 1u);
+        const unsigned int entry = lists_.front(fromT1 ? T1 : T2);
+        lists_.unlink(entry);
+        if (!refBit_[entry]) {
+            lists_.pushFront(fromT1 ? B1 : B2, entry);
+            return;
+        }
+        // Referenced again since the hand last passed, so it has been seen twice
+        refBit_[entry] = false;
+        lists_.pushBack(T2, entry);
+    }
+}
+
+/*!
+ *  \brief Calculate number of page hits when using the CLOCK-Pro page replacement policy.
+ *
+ *  Calculates the number of page cache hits generated for a given sequence of
+ *  page accesses when using the CLOCK-Pro page replacement policy.
+ *
+ *  \param workload Page accesses to evaluate
+ *  \param memsize Memory size, in pages
+ *  \return Number of cache hits generated by using CLOCK-Pro policy
+ */
+int PRP_CLOCK_PRO(const DenseWorkload& workload, unsigned int memsize) {
+    ClockProPolicy<uint32_t> policy(memsize, workload.universe);
+    return replay(policy, workload.pages());
+}
+
+template <typename PageId>
+int PRP_CLOCK_PRO(const vector<PageId>& workload, unsigned int memsize) {
+    return PRP_CLOCK_PRO(DenseWorkload(workload), memsize);
+}
+
+/*
+ * coldTarget_ never drops below one and the hot pages are balanced before
+ * every cold hand move, so there is always a resident cold page for the cold
+ * hand once memory is full.
+ */
+template <typename PageId>
+ClockProPolicy<PageId>::ClockProPolicy(unsigned int memsize, unsigned int universe)
+    : Policy<PageId>(memsize), lists_(2 * static_cast<size_t>(memsize), NUM_LISTS),
+      resident_(2 * static_cast<size_t>(memsize), NUM_LISTS),
+      entryPage_(2 * static_cast<size_t>(memsize), INVALID_PAGE<PageId>),
+      refBit_(2 * static_cast<size_t>(memsize), false), testBit_(2 * static_cast<size_t>(memsize), false),
+      placed_(2 * static_cast<size_t>(memsize), 0), clock_(0), coldHand_(EntryLists::NIL),
+      testHand_(EntryLists::NIL), coldTarget_(std::max(memsize / 100, 1u)), index_(2 * memsize, universe) {
+}
+
+template <typename PageId>
+bool ClockProPolicy<PageId>::access(PageId page) {
+    unsigned int entry = index_.find(page);
+    if (entry != SlotIndex<PageId>::NOT_FOUND) {
+        if (lists_.listOf(entry) == HOT || resident_.linked(entry)) {
+            // Cache hit, the hands will see the reference bit
+            refBit_[entry] = true;
+            return this->record(true);
+        }
+        // Missed during its test period: the page deserved to stay, so give
+        // cold pages more room and bring the page back hot
+        coldTarget_ = std::min(coldTarget_ + 1, this->memsize_);
+        unlinkCold(entry);
+        evict();
+        refBit_[entry] = false;
+        pushHead(HOT, entry);
+        balance();
+        return this->record(false);
+    }
+    if (this->memsize_ == 0) {
+        return this->record(false);
+    }
+    // Memory fills with hot pages up to their share, after that new pages
+    // come in cold on test
+    const bool filling = lists_.size(HOT) + resident_.size(COLD) < this->memsize_;
+    evict();
+    entry = lists_.allocate();
+    entryPage_[entry] = page;
+    index_.insert(page, entry);
+    refBit_[entry] = false;
+    testBit_[entry] = true;
+    pushHead(filling && lists_.size(HOT) < this->memsize_ - coldTarget_ ? HOT : COLD, entry);
+    return this->record(false);
+}
+
+template <typename PageId>
+void ClockProPolicy<PageId>::reset() {
+    lists_.clear();
+    resident_.clear();
+    clock_ = 0;
+    coldHand_ = EntryLists::NIL;
+    testHand_ = EntryLists::NIL;
+    coldTarget_ = std::max(this->memsize_ / 100, 1u);
+    index_.clear();
+    this->clearStats();
+}
+
+template <typename PageId>
+size_t ClockProPolicy<PageId>::access_batch(const PageId* pages, size_t n, uint8_t* hit_out) {
+    return batch(*this, pages, n, hit_out);
+}
+
+template <typename PageId>
+void ClockProPolicy<PageId>::prefetch(PageId page) const {
+    index_.prefetch(page);
+}
+
+template <typename PageId>
+void ClockProPolicy<PageId>::evict() {
+    while (lists_.size(HOT) + resident_.size(COLD) >= this->memsize_) {
+        balance();
+        runHandCold();
+    }
+}
+
+template <typename PageId>
+void ClockProPolicy<PageId>::balance() {
+    while (lists_.size(HOT) > this->memsize_ - coldTarget_) {
+        runHandHot();
+    }
+}
 
-        if (iter != cache.end()) {
-            // Cache hit
-            hits++;
-            iter->second = true;
+template <typename PageId>
+void ClockProPolicy<PageId>::runHandCold() {
+    const unsigned int entry = coldHand_;
+    if (refBit_[entry]) {
+        refBit_[entry] = false;
+        unlinkCold(entry);
+        if (testBit_[entry]) {
+            // Reused within its test period, so its reuse distance is short
+            coldTarget_ = std::min(coldTarget_ + 1, this->memsize_);
+            pushHead(HOT, entry);
         } else {
-            // Cache miss
-            if (cache.size() < memsize) {
-                // Cache can fit another page
-                cache.emplace_back(access, true);
+            testBit_[entry] = true;
+            pushHead(COLD, entry);
+        }
+        return;
+    }
+    if (!testBit_[entry]) {
+        unlinkCold(entry);
+        index_.erase(entryPage_[entry]);
+        lists_.release(entry);
+        return;
+    }
+    // Evict, but keep the page on the circle until its test period ends
+    unlinkResident(entry);
+    if (lists_.size(COLD) - resident_.size(COLD) > this->memsize_) {
+        runHandTest();
+    }
+}
+
+template <typename PageId>
+void ClockProPolicy<PageId>::runHandHot() {
+    for (;;) {
+        const unsigned int hot = lists_.front(HOT);
+        const unsigned int cold = lists_.front(COLD);
+        if (cold != EntryLists::NIL && placed_[cold] < placed_[hot]) {
+            // A cold page comes first on the circle
+            if (!resident_.linked(cold)) {
+                removeNonResident(cold);
+                continue;
+            }
+            // Passing it leaves it at the head, and both its rings in order
+            endTest(cold);
+            placed_[cold] = ++clock_;
+            lists_.unlink(cold);
+            lists_.pushBack(COLD, cold);
+            resident_.unlink(cold);
+            resident_.pushBack(COLD, cold);
+            continue;
+        }
+        lists_.unlink(hot);
+        if (refBit_[hot]) {
+            refBit_[hot] = false;
+            pushHead(HOT, hot);
+            continue;
+        }
+        testBit_[hot] = false;
+        pushHead(COLD, hot);
+        return;
+    }
+}
+
+template <typename PageId>
+void ClockProPolicy<PageId>::runHandTest() {
+    for (;;) {
+        const unsigned int entry = testHand_;
+        if (!resident_.linked(entry)) {
+            removeNonResident(entry);
+            return;
+        }
+        endTest(entry);
+        testHand_ = following(lists_, COLD, entry);
+    }
+}
+
+template <typename PageId>
+void ClockProPolicy<PageId>::endTest(unsigned int entry) {
+    if (testBit_[entry]) {
+        testBit_[entry] = false;
+        // No reference during the test period, so cold pages get less room
+        if (!refBit_[entry] && coldTarget_ > 1) coldTarget_--;
+    }
+}
+
+template <typename PageId>
+void ClockProPolicy<PageId>::removeNonResident(unsigned int entry) {
+    unlinkCold(entry);
+    index_.erase(entryPage_[entry]);
+    lists_.release(entry);
+    if (coldTarget_ > 1) coldTarget_--;
+}
+
+template <typename PageId>
+void ClockProPolicy<PageId>::pushHead(List list, unsigned int entry) {
+    placed_[entry] = ++clock_;
+    lists_.pushBack(list, entry);
+    if (list == COLD) {
+        resident_.pushBack(COLD, entry);
+        if (testHand_ == EntryLists::NIL) testHand_ = entry;
+        if (coldHand_ == EntryLists::NIL) coldHand_ = entry;
+    }
+}
+
+template <typename PageId>
+void ClockProPolicy<PageId>::unlinkCold(unsigned int entry) {
+    if (resident_.linked(entry)) unlinkResident(entry);
+    if (testHand_ == entry) testHand_ = following(lists_, COLD, entry);
+    lists_.unlink(entry);
+}
+
+template <typename PageId>
+void ClockProPolicy<PageId>::unlinkResident(unsigned int entry) {
+    if (coldHand_ == entry) coldHand_ = following(resident_, COLD, entry);
+    resident_.unlink(entry);
+}
+
+template <typename PageId>
+unsigned int ClockProPolicy<PageId>::following(const EntryLists& lists, unsigned int list, unsigned int entry) {
+    unsigned int next = lists.next(entry);
+    if (next == EntryLists::NIL) next = lists.front(list);
+    return next == entry ? EntryLists::NIL : next;
+}
+
+/*!
+ *  \brief Calculate number of page hits when using the LIRS page replacement policy.
+ *
+ *  Calculates the number of page cache hits generated for a given sequence of
+ *  page accesses when using the Low Inter-reference Recency Set policy.
+ *
+ *  \param workload Page accesses to evaluate
+ *  \param memsize Memory size, in pages
+ *  \return Number of cache hits generated by using LIRS policy
+ */
+int PRP_LIRS(const DenseWorkload& workload, unsigned int memsize) {
+    LirsPolicy<uint32_t> policy(memsize, workload.universe);
+    return replay(policy, workload.pages());
+}
+
+template <typename PageId>
+int PRP_LIRS(const vector<PageId>& workload, unsigned int memsize) {
+    return PRP_LIRS(DenseWorkload(workload), memsize);
+}
+
+// Share of memory, in percent, holding resident HIR pages, as in the paper
+static const unsigned int LIRS_HIR_PERCENT = 1;
+
+/*
+ * The front of S is its top. Every resident page and every non-resident entry
+ * still in S has an entry; a non-resident page that leaves S is forgotten at
+ * once. With one page of memory there is no room for a LIR page, so a page
+ * that would be promoted stays HIR and LIRS behaves like FIFO.
+ */
+template <typename PageId>
+LirsPolicy<PageId>::LirsPolicy(unsigned int memsize, unsigned int universe)
+    : Policy<PageId>(memsize), stack_(2 * static_cast<size_t>(memsize), 1),
+      queues_(2 * static_cast<size_t>(memsize), NUM_QUEUES),
+      entryPage_(2 * static_cast<size_t>(memsize), INVALID_PAGE<PageId>),
+      status_(2 * static_cast<size_t>(memsize), NON_RESIDENT),
+      lirCapacity_(memsize - std::min(memsize, std::max(memsize * LIRS_HIR_PERCENT / 100, 1u))),
+      lirCount_(0), index_(2 * memsize, universe) {
+}
+
+template <typename PageId>
+bool LirsPolicy<PageId>::access(PageId page) {
+    unsigned int entry = index_.find(page);
+    if (entry != SlotIndex<PageId>::NOT_FOUND) {
+        switch (status_[entry]) {
+        case LIR:
+            if (entry != stack_.front(0)) {
+                const bool bottom = entry == stack_.back(0);
+                stack_.unlink(entry);
+                stack_.pushFront(0, entry);
+                if (bottom) prune();
+            }
+            return this->record(true);
+        case HIR:
+            queues_.unlink(entry);
+            if (stack_.linked(entry)) {
+                // Reused sooner than the oldest LIR page was, so they swap
+                stack_.unlink(entry);
+                promote(entry);
             } else {
-                // Select a victim page to evict
-                Clock::iterator clockHand = cache.begin();
-                for (; clockHand != cache.end(); clockHand++) {
-                    if (clockHand->second) {
-                        clockHand->second = false;
-                    } else {
-                        break;
-                    }
-                }
-                // Loop back to first page in cache if clockHand went past last entry
-                if (clockHand == cache.end()) {
-                    clockHand = cache.begin();
-                }
-
-                // Replace victim page in cache with page we are now accessing
-                clockHand->first = access;
-                clockHand->second = true;
+                stack_.pushFront(0, entry);
+                queues_.pushBack(RESIDENT_HIR, entry);
             }
+            return this->record(true);
+        default:
+            // Non-resident, but still in S, so its reuse distance is short
+            queues_.unlink(entry);
+            stack_.unlink(entry);
+            if (lirCount_ + queues_.size(RESIDENT_HIR) == this->memsize_) {
+                evict();
+            }
+            promote(entry);
+            return this->record(false);
         }
     }
+    if (this->memsize_ == 0) {
+        return this->record(false);
+    }
 
-    return hits;
+    if (lirCount_ < lirCapacity_) {
+        // Memory is not full yet, every page starts out LIR
+        entry = stack_.allocate();
+        entryPage_[entry] = page;
+        index_.insert(page, entry);
+        status_[entry] = LIR;
+        lirCount_++;
+        stack_.pushFront(0, entry);
+        return this->record(false);
+    }
+    if (lirCount_ + queues_.size(RESIDENT_HIR) == this->memsize_) {
+        evict();
+    }
+    entry = stack_.allocate();
+    entryPage_[entry] = page;
+    index_.insert(page, entry);
+    status_[entry] = HIR;
+    stack_.pushFront(0, entry);
+    queues_.pushBack(RESIDENT_HIR, entry);
+    return this->record(false);
+}
+
+template <typename PageId>
+void LirsPolicy<PageId>::reset() {
+    stack_.clear();
+    queues_.clear();
+    lirCount_ = 0;
+    index_.clear();
+    this->clearStats();
+}
+
+template <typename PageId>
+size_t LirsPolicy<PageId>::access_batch(const PageId* pages, size_t n, uint8_t* hit_out) {
+    return batch(*this, pages, n, hit_out);
 }
+
+template <typename PageId>
+void LirsPolicy<PageId>::prefetch(PageId page) const {
+    index_.prefetch(page);
+}
+
+template <typename PageId>
+void LirsPolicy<PageId>::promote(unsigned int entry) {
+    if (lirCapacity_ == 0) {
+        status_[entry] = HIR;
+        stack_.pushFront(0, entry);
+        queues_.pushBack(RESIDENT_HIR, entry);
+        return;
+    }
+    status_[entry] = LIR;
+    lirCount_++;
+    stack_.pushFront(0, entry);
+    if (lirCount_ > lirCapacity_) {
+        const unsigned int bottom = stack_.back(0);
+        stack_.unlink(bottom);
+        status_[bottom] = HIR;
+        lirCount_--;
+        queues_.pushBack(RESIDENT_HIR, bottom);
+        prune();
+    }
+}
+
+template <typename PageId>
+void LirsPolicy<PageId>::evict() {
+    const unsigned int entry = queues_.front(RESIDENT_HIR);
+    queues_.unlink(entry);
+    if (!stack_.linked(entry)) {
+        index_.erase(entryPage_[entry]);
+        stack_.release(entry);
+        return;
+    }
+    status_[entry] = NON_RESIDENT;
+    queues_.pushBack(NON_RESIDENT_HIR, entry);
+    if (queues_.size(NON_RESIDENT_HIR) > this->memsize_) {
+        forget(queues_.front(NON_RESIDENT_HIR));
+    }
+}
+
+template <typename PageId>
+void LirsPolicy<PageId>::prune() {
+    // Each entry popped here was pushed once, so pruning is amortized O(1)
+    while (stack_.size(0) > 0) {
+        const unsigned int bottom = stack_.back(0);
+        if (status_[bottom] == LIR) break;
+        if (status_[bottom] == NON_RESIDENT) {
+            forget(bottom);
+        } else {
+            stack_.unlink(bottom);
+        }
+    }
+}
+
+template <typename PageId>
+void LirsPolicy<PageId>::forget(unsigned int entry) {
+    stack_.unlink(entry);
+    queues_.unlink(entry);
+    index_.erase(entryPage_[entry]);
+    stack_.release(entry);
+}
+
+/*!
+ *  \brief Calculate number of page hits when using the W-TinyLFU page replacement policy.
+ *
+ *  Calculates the number of page cache hits generated for a given sequence of
+ *  page accesses when using the W-TinyLFU admission and replacement policy.
+ *
+ *  \param workload Page accesses to evaluate
+ *  \param memsize Memory size, in pages
+ *  \return Number of cache hits generated by using W-TinyLFU policy
+ */
+int PRP_WTINYLFU(const DenseWorkload& workload, unsigned int memsize) {
+    WTinyLfuPolicy<uint32_t> policy(memsize, workload.universe);
+    return replay(policy, workload.pages());
+}
+
+template <typename PageId>
+int PRP_WTINYLFU(const vector<PageId>& workload, unsigned int memsize) {
+    return PRP_WTINYLFU(DenseWorkload(workload), memsize);
+}
+
+// Shares of memory, in percent, given to the window and to the protected
+// segment of the main region, the defaults of the paper and of Caffeine
+static const unsigned int WTINYLFU_WINDOW_PERCENT = 1;
+static const unsigned int WTINYLFU_PROTECTED_PERCENT = 80;
+
+template <typename PageId>
+WTinyLfuPolicy<PageId>::WTinyLfuPolicy(unsigned int memsize, unsigned int universe)
+    : Policy<PageId>(memsize), lists_(memsize, NUM_LISTS), entryPage_(memsize, INVALID_PAGE<PageId>),
+      windowCapacity_(std::max(memsize * WTINYLFU_WINDOW_PERCENT / 100, 1u)),
+      protectedCapacity_((memsize - std::min(memsize, windowCapacity_)) * WTINYLFU_PROTECTED_PERCENT / 100),
+      sketch_(memsize), index_(memsize, universe) {
+}
+
+template <typename PageId>
+bool WTinyLfuPolicy<PageId>::access(PageId page) {
+    sketch_.increment(page);
+    unsigned int entry = index_.find(page);
+    if (entry != SlotIndex<PageId>::NOT_FOUND) {
+        const List list = static_cast<List>(lists_.listOf(entry));
+        lists_.unlink(entry);
+        if (list == WINDOW) {
+            lists_.pushFront(WINDOW, entry);
+        } else {
+            // Hit in the main region, so the page has earned protection
+            lists_.pushFront(PROTECTED, entry);
+            if (lists_.size(PROTECTED) > protectedCapacity_) {
+                const unsigned int demoted = lists_.back(PROTECTED);
+                lists_.unlink(demoted);
+                lists_.pushFront(PROBATION, demoted);
+            }
+        }
+        return this->record(true);
+    }
+    if (this->memsize_ == 0) {
+        return this->record(false);
+    }
+
+    const unsigned int resident = lists_.size(WINDOW) + lists_.size(PROBATION) + lists_.size(PROTECTED);
+    if (resident == this->memsize_) {
+        evict();
+    }
+    entry = lists_.allocate();
+    entryPage_[entry] = page;
+    index_.insert(page, entry);
+    lists_.pushFront(WINDOW, entry);
+    if (lists_.size(WINDOW) > windowCapacity_) {
+        // Memory is not full yet, so the main region takes the page unfiltered
+        const unsigned int candidate = lists_.back(WINDOW);
+        lists_.unlink(candidate);
+        lists_.pushFront(PROBATION, candidate);
+    }
+    return this->record(false);
+}
+
+template <typename PageId>
+void WTinyLfuPolicy<PageId>::reset() {
+    lists_.clear();
+    sketch_.clear();
+    index_.clear();
+    this->clearStats();
+}
+
+template <typename PageId>
+size_t WTinyLfuPolicy<PageId>::access_batch(const PageId* pages, size_t n, uint8_t* hit_out) {
+    return batch(*this, pages, n, hit_out);
+}
+
+template <typename PageId>
+void WTinyLfuPolicy<PageId>::prefetch(PageId page) const {
+    sketch_.prefetch(page);
+    index_.prefetch(page);
+}
+
+template <typename PageId>
+void WTinyLfuPolicy<PageId>::evict() {
+    const unsigned int candidate = lists_.back(WINDOW);
+    // Probation holds the main region's eviction order, then protected
+    unsigned int victim = lists_.back(PROBATION);
+    if (victim == EntryLists::NIL) victim = lists_.back(PROTECTED);
+    if (victim == EntryLists::NIL) {
+        // No main region at all, the window is all of memory
+        drop(candidate);
+        return;
+    }
+    // Ties go to the incumbent, so a scan cannot flush the main region
+    if (sketch_.frequency(entryPage_[candidate]) > sketch_.frequency(entryPage_[victim])) {
+        drop(victim);
+        lists_.unlink(candidate);
+        lists_.pushFront(PROBATION, candidate);
+    } else {
+        drop(candidate);
+    }
+}
+
+template <typename PageId>
+void WTinyLfuPolicy<PageId>::drop(unsigned int entry) {
+    lists_.unlink(entry);
+    index_.erase(entryPage_[entry]);
+    lists_.release(entry);
+}
+
+#define INSTANTIATE_POLICIES(PageId) \
+    template class Policy<PageId>; \
+    template class FifoPolicy<PageId>; \
+    template class OptPolicy<PageId>; \
+    template class RandPolicy<PageId>; \
+    template class LruPolicy<PageId>; \
+    template class ClockPolicy<PageId>; \
+    template class ArcPolicy<PageId>; \
+    template class CarPolicy<PageId>; \
+    template class ClockProPolicy<PageId>; \
+    template class LirsPolicy<PageId>; \
+    template class WTinyLfuPolicy<PageId>; \
+    template int PRP_FIFO(const vector<PageId>&, unsigned int); \
+    template int PRP_OPT(const vector<PageId>&, unsigned int); \
+    template int PRP_RAND(const vector<PageId>&, unsigned int); \
+    template int PRP_RAND_seeded(const vector<PageId>&, unsigned int, uint64_t); \
+    template vector<int> PRP_RAND_seeds(const vector<PageId>&, unsigned int, const vector<uint64_t>&); \
+    template int PRP_LRU(const vector<PageId>&, unsigned int); \
+    template int PRP_CLOCK(const vector<PageId>&, unsigned int); \
+    template int PRP_ARC(const vector<PageId>&, unsigned int); \
+    template int PRP_CAR(const vector<PageId>&, unsigned int); \
+    template int PRP_CLOCK_PRO(const vector<PageId>&, unsigned int); \
+    template int PRP_LIRS(const vector<PageId>&, unsigned int); \
+    template int PRP_WTINYLFU(const vector<PageId>&, unsigned int); \
+    template vector<int> OPT_hit_curve(const vector<PageId>&, unsigned int); \
+    template vector<int> LRU_hit_curve(const vector<PageId>&, unsigned int);
+
+INSTANTIATE_POLICIES(uint32_t)
+INSTANTIATE_POLICIES(uint64_t)
@@ -3,15 +3,593 @@
 #define POLICIES_HPP_
 
 #include <vector>
+#include <deque>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include "flat_map.hpp"
+#include "slot_index.hpp"
+#include "frequency_sketch.hpp"
+#include "rng.hpp"
+#include "remap.hpp"
 
-// PRP function pointer type
-typedef int (*PageReplacementPolicy)(const std::vector<int>&, unsigned int); 
+// PRP function pointer type, for workloads of 32 or 64 bit page ids
+template <typename PageId>
+using PageReplacementPolicy = int (*)(const std::vector<PageId>&, unsigned int);
 //Added memsize param to the function type, because this varies between runs as well.
 
-int PRP_FIFO(const std::vector<int>& workload, unsigned int memsize);
-int PRP_OPT(const std::vector<int>& workload, unsigned int memsize);
-int PRP_RAND(const std::vector<int>& workload, unsigned int memsize);
-int PRP_LRU(const std::vector<int>& workload, unsigned int memsize);
-int PRP_CLOCK(const std::vector<int>& workload, unsigned int memsize);
+// Hit curve function pointer type, for stack algorithms that can compute the
+// hits for every memory size in a single pass over the workload.
+// Element m of the result is the number of hits with a memory of m pages.
+template <typename PageId>
+using HitCurvePolicy = std::vector<int> (*)(const std::vector<PageId>&, unsigned int);
+
+// Seed of the generator behind PRP_RAND
+static const uint64_t RAND_DEFAULT_SEED = 0x5EED;
+
+/*!
+ *  \brief A workload whose pages are all dense 32-bit ids below universe.
+ *
+ *  Workloads over a small range of pages are used in place (or narrowed, for
+ *  64-bit ids), any other workload is remapped to dense ids first, so that the
+ *  wrappers can always run the 32-bit policies on flat per-page arrays. A
+ *  sweep builds one per workload and passes it to every run; one used in
+ *  place must not outlive the vector it was built from.
+ */
+struct DenseWorkload {
+    template <typename PageId>
+    explicit DenseWorkload(const std::vector<PageId>& workload) : original(NULL), universe(0) {
+        PageId largest = 0;
+        for (PageId page : workload) {
+            largest = std::max(largest, page);
+        }
+        if (largest < 2 * workload.size() + DENSE_SLACK) {
+            universe = largest + 1;
+            useSmall(workload);
+        } else {
+            remapped.resize(workload.size());
+            universe = remap_dense(workload.data(), workload.size(), remapped.data());
+        }
+    }
+
+    const std::vector<uint32_t>& pages() const { return original ? *original : remapped; }
+
+    // Pages below this many are always used in place
+    static const size_t DENSE_SLACK = 1 << 16;
+
+    const std::vector<uint32_t>* original;
+    std::vector<uint32_t> remapped;
+    unsigned int universe;
+
+private:
+    void useSmall(const std::vector<uint32_t>& workload) { original = &workload; }
+    void useSmall(const std::vector<uint64_t>& workload) { remapped.assign(workload.begin(), workload.end()); }
+};
+
+// The same function pointer types, on a workload made dense beforehand
+typedef int (*DensePolicy)(const DenseWorkload&, unsigned int);
+typedef std::vector<int> (*DenseHitCurve)(const DenseWorkload&, unsigned int);
+
+// The wrappers are instantiated for uint32_t and uint64_t page ids, and make
+// the workload dense on every call
+template <typename PageId> int PRP_FIFO(const std::vector<PageId>& workload, unsigned int memsize);
+template <typename PageId> int PRP_OPT(const std::vector<PageId>& workload, unsigned int memsize);
+template <typename PageId> int PRP_RAND(const std::vector<PageId>& workload, unsigned int memsize);
+template <typename PageId> int PRP_RAND_seeded(const std::vector<PageId>& workload, unsigned int memsize, uint64_t seed);
+template <typename PageId> std::vector<int> PRP_RAND_seeds(const std::vector<PageId>& workload, unsigned int memsize, const std::vector<uint64_t>& seeds);
+template <typename PageId> int PRP_LRU(const std::vector<PageId>& workload, unsigned int memsize);
+template <typename PageId> int PRP_CLOCK(const std::vector<PageId>& workload, unsigned int memsize);
+template <typename PageId> int PRP_ARC(const std::vector<PageId>& workload, unsigned int memsize);
+template <typename PageId> int PRP_CAR(const std::vector<PageId>& workload, unsigned int memsize);
+template <typename PageId> int PRP_CLOCK_PRO(const std::vector<PageId>& workload, unsigned int memsize);
+template <typename PageId> int PRP_LIRS(const std::vector<PageId>& workload, unsigned int memsize);
+template <typename PageId> int PRP_WTINYLFU(const std::vector<PageId>& workload, unsigned int memsize);
+
+template <typename PageId> std::vector<int> OPT_hit_curve(const std::vector<PageId>& workload, unsigned int max_memsize);
+template <typename PageId> std::vector<int> LRU_hit_curve(const std::vector<PageId>& workload, unsigned int max_memsize);
+
+// The wrappers on a DenseWorkload, for sweeps that run many policies and
+// memory sizes over the same workload
+int PRP_FIFO(const DenseWorkload& workload, unsigned int memsize);
+int PRP_OPT(const DenseWorkload& workload, unsigned int memsize);
+int PRP_RAND(const DenseWorkload& workload, unsigned int memsize);
+int PRP_RAND_seeded(const DenseWorkload& workload, unsigned int memsize, uint64_t seed);
+std::vector<int> PRP_RAND_seeds(const DenseWorkload& workload, unsigned int memsize, const std::vector<uint64_t>& seeds);
+int PRP_LRU(const DenseWorkload& workload, unsigned int memsize);
+int PRP_CLOCK(const DenseWorkload& workload, unsigned int memsize);
+int PRP_ARC(const DenseWorkload& workload, unsigned int memsize);
+int PRP_CAR(const DenseWorkload& workload, unsigned int memsize);
+int PRP_CLOCK_PRO(const DenseWorkload& workload, unsigned int memsize);
+int PRP_LIRS(const DenseWorkload& workload, unsigned int memsize);
+int PRP_WTINYLFU(const DenseWorkload& workload, unsigned int memsize);
+
+std::vector<int> OPT_hit_curve(const DenseWorkload& workload, unsigned int max_memsize);
+std::vector<int> LRU_hit_curve(const DenseWorkload& workload, unsigned int max_memsize);
+
+// Running counters of an incremental policy
+struct PolicyStats {
+    uint64_t accesses;
+    uint64_t hits;
+
+    uint64_t misses() const { return accesses - hits; }
+};
+
+/*!
+ *  \brief Incremental page replacement policy.
+ *
+ *  Policy objects own the state of one simulated memory and are fed one access
+ *  at a time, so they can consume live access streams and be inspected or
+ *  paused between accesses.
+ *
+ *  Templated on the page id type, uint32_t or uint64_t, and instantiated for
+ *  both in policies.cpp. The largest id of the type is reserved.
+ *
+ *  Constructors take an optional universe size. When it is non-zero, every page
+ *  must be below it (see remap_dense) and per-page state is kept in flat arrays
+ *  indexed by page instead of hash tables.
+ */
+template <typename PageId>
+class Policy {
+public:
+    virtual ~Policy() {}
+
+    /*!
+     *  \brief Access a page, bringing it into memory on a miss.
+     *  \return true on a hit, false on a miss
+     */
+    virtual bool access(PageId page) = 0;
+
+    /*!
+     *  \brief Access a block of pages in order.
+     *
+     *  Equivalent to calling access() on each page, but runs as one tight loop
+     *  that prefetches the index entries of upcoming pages.
+     *
+     *  \param pages Pages to access
+     *  \param n Number of pages
+     *  \param hit_out If not NULL, receives 1 for each hit and 0 for each miss
+     *  \return Number of hits in the block
+     */
+    virtual size_t access_batch(const PageId* pages, size_t n, uint8_t* hit_out);
+
+    // Empty the memory and clear the statistics
+    virtual void reset() = 0;
+
+    const PolicyStats& stats() const { return stats_; }
+    unsigned int memsize() const { return memsize_; }
+
+protected:
+    explicit Policy(unsigned int memsize) : memsize_(memsize) { clearStats(); }
+
+    bool record(bool hit) {
+        stats_.accesses++;
+        stats_.hits += hit;
+        return hit;
+    }
+    void clearStats() {
+        stats_.accesses = 0;
+        stats_.hits = 0;
+    }
+
+    unsigned int memsize_;
+
+private:
+    PolicyStats stats_;
+};
+
+// First in, first out over a ring of frames
+template <typename PageId>
+class FifoPolicy final : public Policy<PageId> {
+public:
+    explicit FifoPolicy(unsigned int memsize, unsigned int universe = 0);
+    bool access(PageId page) override;
+    size_t access_batch(const PageId* pages, size_t n, uint8_t* hit_out) override;
+    void reset() override;
+    // Hint that page is about to be accessed
+    void prefetch(PageId page) const;
+
+private:
+    std::vector<PageId> frames_;
+    unsigned int head_;
+    SlotIndex<PageId> index_;
+};
+
+/*!
+ *  \brief Optimal (Belady) policy driven by a lookahead window.
+ *
+ *  Future accesses are announced with lookahead() and must then be accessed in
+ *  the same order. The victim is the resident page whose next announced use is
+ *  furthest away, pages with no announced use first (least recently used among
+ *  them). Announcing the whole trace up front gives the true optimal policy; a
+ *  shorter window gives OPT limited to that much knowledge of the future.
+ *  Accessing with nothing announced announces the page first.
+ */
+template <typename PageId>
+class OptPolicy final : public Policy<PageId> {
+public:
+    explicit OptPolicy(unsigned int memsize, unsigned int universe = 0);
+    void lookahead(PageId page);
+    bool access(PageId page) override;
+    size_t access_batch(const PageId* pages, size_t n, uint8_t* hit_out) override;
+    void reset() override;
+    // Hint that page is about to be accessed
+    void prefetch(PageId page) const;
+
+private:
+    void push(uint64_t key, unsigned int frame);
+    void compact();
+    // Time of the last announced access of page, or NULL if not kept
+    uint64_t* announced(PageId page);
+    void setAnnounced(PageId page, uint64_t time);
+    void forgetAnnounced(PageId page);
+
+    uint64_t time_;     // accesses consumed so far
+    uint64_t horizon_;  // accesses announced so far
+    // Next use of each announced access not yet consumed, starting at time_
+    std::deque<uint64_t> nextUse_;
+    // Key: page Value: time of its last announced access. Only kept for pages
+    // in the window or in memory. Indexed by page instead with a universe.
+    FlatHashMap<PageId, uint64_t> lastAnnounced_;
+    std::vector<uint64_t> lastAnnouncedDense_;
+    bool dense_;
+    std::vector<PageId> framePage_;
+    std::vector<uint64_t> frameKey_;
+    SlotIndex<PageId> index_;
+    // Max-heap of (next use, frame), entries whose key no longer matches the
+    // frame are stale and skipped
+    std::vector<std::pair<uint64_t, unsigned int>> heap_;
+};
+
+// Random replacement with a seeded xoshiro256** generator
+template <typename PageId>
+class RandPolicy final : public Policy<PageId> {
+public:
+    RandPolicy(unsigned int memsize, uint64_t seed, unsigned int universe = 0);
+    bool access(PageId page) override;
+    size_t access_batch(const PageId* pages, size_t n, uint8_t* hit_out) override;
+    void reset() override;
+    // Hint that page is about to be accessed
+    void prefetch(PageId page) const;
+
+private:
+    uint64_t seed_;
+    std::vector<PageId> frames_;
+    SlotIndex<PageId> index_;
+    Xoshiro256 random_engine_;
+};
+
+// Least recently used over an intrusive doubly-linked recency list
+template <typename PageId>
+class LruPolicy final : public Policy<PageId> {
+public:
+    explicit LruPolicy(unsigned int memsize, unsigned int universe = 0);
+    bool access(PageId page) override;
+    size_t access_batch(const PageId* pages, size_t n, uint8_t* hit_out) override;
+    void reset() override;
+    // Hint that page is about to be accessed
+    void prefetch(PageId page) const;
+
+private:
+    void unlink(unsigned int frame);
+    void pushFront(unsigned int frame);
+
+    std::vector<PageId> framePage_;
+    std::vector<unsigned int> prev_;
+    std::vector<unsigned int> next_;
+    unsigned int head_;
+    unsigned int tail_;
+    unsigned int used_;
+    SlotIndex<PageId> index_;
+};
+
+// CLOCK (second chance) with a persistent hand
+template <typename PageId>
+class ClockPolicy final : public Policy<PageId> {
+public:
+    explicit ClockPolicy(unsigned int memsize, unsigned int universe = 0);
+    bool access(PageId page) override;
+    size_t access_batch(const PageId* pages, size_t n, uint8_t* hit_out) override;
+    void reset() override;
+    // Hint that page is about to be accessed
+    void prefetch(PageId page) const;
+
+private:
+    std::vector<PageId> framePage_;
+    std::vector<unsigned char> useBit_;
+    unsigned int clockHand_;
+    SlotIndex<PageId> index_;
+};
+
+/*!
+ *  \brief Doubly-linked lists threaded by index through a fixed pool of entries.
+ *
+ *  Shared by the policies that keep pages on several recency lists at once and
+ *  move them between lists on every access. Entries are plain indices, so a
+ *  policy keeps its per-entry data in flat arrays beside the lists and nothing
+ *  is allocated after construction. Every operation is O(1).
+ */
+class EntryLists {
+public:
+    static const unsigned int NIL = static_cast<unsigned int>(-1);
+
+    EntryLists(size_t entries, unsigned int lists);
+
+    // Empty every list and return all entries to the free pool
+    void clear();
+    // Take an entry from the free pool, which must not be empty
+    unsigned int allocate();
+    // Return an unlinked entry to the free pool
+    void release(unsigned int entry);
+
+    unsigned int size(unsigned int list) const { return size_[list]; }
+    // First and last entries of a list, NIL when it is empty
+    unsigned int front(unsigned int list) const { return head_[list]; }
+    unsigned int back(unsigned int list) const { return tail_[list]; }
+    // List holding a linked entry
+    unsigned int listOf(unsigned int entry) const { return list_[entry]; }
+    // Whether an entry is on any list
+    bool linked(unsigned int entry) const { return list_[entry] != UNLINKED; }
+    // Entry after a linked one on its list, NIL at the back
+    unsigned int next(unsigned int entry) const { return next_[entry]; }
+
+    void pushFront(unsigned int list, unsigned int entry);
+    void pushBack(unsigned int list, unsigned int entry);
+    void unlink(unsigned int entry);
+
+private:
+    static const unsigned char UNLINKED = 0xff;
+
+    std::vector<unsigned int> prev_;
+    std::vector<unsigned int> next_;
+    std::vector<unsigned char> list_;
+    std::vector<unsigned int> head_;
+    std::vector<unsigned int> tail_;
+    std::vector<unsigned int> size_;
+    std::vector<unsigned int> free_;
+};
+
+/*!
+ *  \brief Adaptive Replacement Cache (Megiddo and Modha).
+ *
+ *  Resident pages are split between T1, seen once recently, and T2, seen at
+ *  least twice recently, while B1 and B2 remember the pages last evicted from
+ *  each. A hit in B1 grows the target size of T1 and a hit in B2 shrinks it, so
+ *  the cache keeps adapting between recency and frequency. All four lists are
+ *  threaded through one pool of 2 * memsize entries under a single index, so
+ *  every access is O(1).
+ */
+template <typename PageId>
+class ArcPolicy final : public Policy<PageId> {
+public:
+    explicit ArcPolicy(unsigned int memsize, unsigned int universe = 0);
+    bool access(PageId page) override;
+    size_t access_batch(const PageId* pages, size_t n, uint8_t* hit_out) override;
+    void reset() override;
+    // Hint that page is about to be accessed
+    void prefetch(PageId page) const;
+    // Current target size of T1, in pages
+    unsigned int target() const { return target_; }
+
+private:
+    enum List { T1, T2, B1, B2, NUM_LISTS };
+
+    // Evict the LRU page of T1 or T2 into its ghost list
+    void replace(bool inB2);
+    // Move the LRU entry of one list to the MRU end of another
+    void demote(List from, List to);
+    // Forget the LRU entry of a list altogether
+    void drop(List list);
+
+    EntryLists lists_;
+    std::vector<PageId> entryPage_;
+    unsigned int target_;
+    SlotIndex<PageId> index_;
+};
+
+/*!
+ *  \brief CLOCK with Adaptive Replacement (Bansal and Modha).
+ *
+ *  ARC with its two LRU lists of resident pages replaced by two clocks, so a
+ *  hit only sets a reference bit, as in CLOCK, and never reorders a list. T1
+ *  holds pages seen once and T2 pages seen again, B1 and B2 are the ghosts of
+ *  each, and ghost hits adapt the target size of T1 exactly as in ARC. Each
+ *  hand step clears a bit set by an earlier hit, so eviction is amortized O(1).
+ */
+template <typename PageId>
+class CarPolicy final : public Policy<PageId> {
+public:
+    explicit CarPolicy(unsigned int memsize, unsigned int universe = 0);
+    bool access(PageId page) override;
+    size_t access_batch(const PageId* pages, size_t n, uint8_t* hit_out) override;
+    void reset() override;
+    // Hint that page is about to be accessed
+    void prefetch(PageId page) const;
+    // Current target size of T1, in pages
+    unsigned int target() const { return target_; }
+
+private:
+    // The clocks T1 and T2 run from their hand at the front to the newest page
+    // at the back; the ghost lists B1 and B2 have their MRU entry at the front
+    enum List { T1, T2, B1, B2, NUM_LISTS };
+
+    // Sweep the clocks until a page without its reference bit is evicted
+    void replace();
+
+    EntryLists lists_;
+    std::vector<PageId> entryPage_;
+    std::vector<unsigned char> refBit_;
+    unsigned int target_;
+    SlotIndex<PageId> index_;
+};
+
+/*!
+ *  \brief CLOCK-Pro (Jiang, Chen and Zhang).
+ *
+ *  Approximates LIRS with clock hands. Resident pages are hot, with a short
+ *  reuse distance, or cold; a cold page starts a test period when it enters
+ *  the clock, and if evicted during it stays on as non-resident metadata, at
+ *  most memsize of them. A cold page referenced within its test period turns
+ *  hot. The test period of a page ends when the hot hand passes it, or the
+ *  test hand when too many non-resident pages are kept.
+ *
+ *  Of memsize frames, coldTarget() may hold cold pages and the hot hand
+ *  demotes hot pages without their reference bit whenever the rest are
+ *  outgrown. The target starts at 1% of memory like the HIR share of LIRS,
+ *  grows by one for every cold page referenced in its test period and shrinks
+ *  by one for every cold page whose test period ends without a reference.
+ *
+ *  All pages sit on one circle as in the paper, but each hand only stops at
+ *  pages it acts on: the cold hand sweeps a ring of the resident cold pages
+ *  and the test hand a ring of all cold pages, both kept in circle order. Hot
+ *  pages are on a ring of their own, and the hot hand, which acts on every
+ *  page, takes whichever of the hot and cold rings comes first on the circle,
+ *  known from when each page was last placed at the head.
+ */
+template <typename PageId>
+class ClockProPolicy final : public Policy<PageId> {
+public:
+    explicit ClockProPolicy(unsigned int memsize, unsigned int universe = 0);
+    bool access(PageId page) override;
+    size_t access_batch(const PageId* pages, size_t n, uint8_t* hit_out) override;
+    void reset() override;
+    // Hint that page is about to be accessed
+    void prefetch(PageId page) const;
+    // Current number of resident pages allowed to be cold
+    unsigned int coldTarget() const { return coldTarget_; }
+
+private:
+    // Each ring runs from the page the hot hand reaches first at the front to
+    // the head of the circle at the back
+    enum List { HOT, COLD, NUM_LISTS };
+
+    // Run the cold hand until a frame is free
+    void evict();
+    // Run the hot hand until it demotes a page, while hot pages are too many
+    void balance();
+    // Move the cold hand past one resident cold page, promoting, retesting or evicting it
+    void runHandCold();
+    // Move the hot hand until it has demoted one hot page
+    void runHandHot();
+    // Move the test hand until it has removed one non-resident page
+    void runHandTest();
+    // End the test period of a cold page the hot or test hand passes
+    void endTest(unsigned int entry);
+    // Drop a non-resident page off the circle, its test period over
+    void removeNonResident(unsigned int entry);
+    // Place an entry at the head of the circle
+    void pushHead(List list, unsigned int entry);
+    // Take an entry off its ring, moving a hand resting on it forward first
+    void unlinkCold(unsigned int entry);
+    void unlinkResident(unsigned int entry);
+    // Next entry round a ring, NIL if entry is alone on it
+    static unsigned int following(const EntryLists& lists, unsigned int list, unsigned int entry);
+
+    // The hot ring and the ring of cold pages, resident or not
+    EntryLists lists_;
+    // The resident cold pages, in their order on the COLD ring of lists_
+    EntryLists resident_;
+    std::vector<PageId> entryPage_;
+    std::vector<unsigned char> refBit_;
+    std::vector<unsigned char> testBit_;
+    // When each entry was last placed at the head, which orders the circle
+    std::vector<uint64_t> placed_;
+    uint64_t clock_;
+    unsigned int coldHand_;
+    unsigned int testHand_;
+    unsigned int coldTarget_;
+    SlotIndex<PageId> index_;
+};
+
+/*!
+ *  \brief Low Inter-reference Recency Set (Jiang and Zhang).
+ *
+ *  Pages whose last two accesses were close together are LIR and always stay
+ *  resident; the rest are HIR, and only a small share of memory holds resident
+ *  HIR pages, evicted in FIFO order. The stack S orders pages by recency and
+ *  always has a LIR page at the bottom, so a HIR page found in S was reused
+ *  more recently than the oldest LIR page and swaps places with it. This keeps
+ *  a loop longer than memory from flushing the LIR pages, where LRU misses on
+ *  every access.
+ *
+ *  Evicted HIR pages stay in S as non-resident entries until pruned off the
+ *  bottom, and at most memsize of them are kept, the oldest forgotten first.
+ *  S, the HIR queue and the non-resident entries all live in one pool of
+ *  2 * memsize entries, so every access is amortized O(1) and memory stays
+ *  bounded however long the trace.
+ */
+template <typename PageId>
+class LirsPolicy final : public Policy<PageId> {
+public:
+    explicit LirsPolicy(unsigned int memsize, unsigned int universe = 0);
+    bool access(PageId page) override;
+    size_t access_batch(const PageId* pages, size_t n, uint8_t* hit_out) override;
+    void reset() override;
+    // Hint that page is about to be accessed
+    void prefetch(PageId page) const;
+    // Number of resident pages set aside for LIR pages
+    unsigned int lirCapacity() const { return lirCapacity_; }
+
+private:
+    enum Status { LIR, HIR, NON_RESIDENT };
+    // Resident HIR pages in FIFO order, and non-resident ones by age
+    enum Queue { RESIDENT_HIR, NON_RESIDENT_HIR, NUM_QUEUES };
+
+    // Push an entry onto S as LIR, demoting the bottom LIR page if there are
+    // now too many
+    void promote(unsigned int entry);
+    // Evict the oldest resident HIR page
+    void evict();
+    // Pop entries off the bottom of S until a LIR page is there
+    void prune();
+    // Drop a non-resident entry altogether
+    void forget(unsigned int entry);
+
+    EntryLists stack_;
+    EntryLists queues_;
+    std::vector<PageId> entryPage_;
+    std::vector<unsigned char> status_;
+    unsigned int lirCapacity_;
+    unsigned int lirCount_;
+    SlotIndex<PageId> index_;
+};
+
+/*!
+ *  \brief W-TinyLFU (Einziger, Friedman and Manes).
+ *
+ *  New pages enter a small LRU window, 1% of memory. A page pushed out of the
+ *  window is only admitted to the main region if the frequency sketch has seen
+ *  it more often lately than the page the main region would evict in its place,
+ *  so one-off pages never displace popular ones while bursts are still absorbed
+ *  by the window. The main region is a segmented LRU: pages start on probation
+ *  and move to the protected segment, 80% of the main region, when hit again.
+ *  Every access is O(1) and costs one cache line of the sketch.
+ */
+template <typename PageId>
+class WTinyLfuPolicy final : public Policy<PageId> {
+public:
+    explicit WTinyLfuPolicy(unsigned int memsize, unsigned int universe = 0);
+    bool access(PageId page) override;
+    size_t access_batch(const PageId* pages, size_t n, uint8_t* hit_out) override;
+    void reset() override;
+    // Hint that page is about to be accessed
+    void prefetch(PageId page) const;
+
+private:
+    // The front of each list is its most recently used page
+    enum List { WINDOW, PROBATION, PROTECTED, NUM_LISTS };
+
+    // Free an entry by evicting either the window's LRU page or the main
+    // region's, whichever the sketch says is less popular
+    void evict();
+    // Forget a resident page
+    void drop(unsigned int entry);
+
+    EntryLists lists_;
+    std::vector<PageId> entryPage_;
+    unsigned int windowCapacity_;
+    unsigned int protectedCapacity_;
+    FrequencySketch sketch_;
+    SlotIndex<PageId> index_;
+};
 
 #endif /* end of include guard: POLICIES_HPP_ */
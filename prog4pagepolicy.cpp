@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -6,6 +8,10 @@
 #include <utility>
 #include "workloads.hpp"
 #include "policies.hpp"
+#include "scheduler.hpp"
+#include "trace_cache.hpp"
+#include "trace_file.hpp"
+#include "perf_counters.hpp"
 
 using std::ofstream;
 using std::vector;
@@ -17,29 +23,238 @@ using std::pair;
 #define MAX_MEM_SIZE 100
 #define NUM_PAGES 100
 #define STEP 5
+#define WORKLOAD_SEED 350
+#define NUM_MEM_SIZES ((MAX_MEM_SIZE - MIN_MEM_SIZE) / STEP + 1)
 
-static const int INVALID_PAGE = -1;
+// The generated workloads span few pages, so 32-bit ids keep the traces compact
+typedef uint32_t PageId;
+
+// Replays a trace file through a policy engine built for it, returning the hits
+template <typename TracePageId>
+using TraceReplay = uint64_t (*)(const TraceReader&, unsigned int);
+
+// A column of the output: either a policy simulated once per memory size,
+// or a stack algorithm whose hits for every memory size come from one pass.
+// Trace files are replayed in place through the engine, for either id width.
+struct PolicyColumn {
+	const char* name;
+	DensePolicy run;
+	DenseHitCurve curve;
+	TraceReplay<uint32_t> replay32;
+	TraceReplay<uint64_t> replay64;
+};
+
+// Captured traces have arbitrary ids, so engines index them by hash instead
+// of by a flat per-page table
+template <template <typename> class Engine, typename TracePageId>
+static uint64_t replay(const TraceReader& reader, unsigned int memsize){
+	Engine<TracePageId> policy(memsize);
+	return simulate_trace(reader, policy);
+}
+
+template <typename TracePageId>
+static uint64_t replay_rand(const TraceReader& reader, unsigned int memsize){
+	RandPolicy<TracePageId> policy(memsize, RAND_DEFAULT_SEED);
+	return simulate_trace(reader, policy);
+}
+
+// OPT is told the whole trace before replaying it
+template <typename TracePageId>
+static uint64_t replay_opt(const TraceReader& reader, unsigned int memsize){
+	OptPolicy<TracePageId> policy(memsize);
+	TraceFileStream<TracePageId> stream(reader);
+	vector<TracePageId> chunk(1 << 16);
+	size_t n;
+	while((n = stream.next(chunk.data(), chunk.size())) > 0){
+		for(size_t i = 0; i < n; i++) policy.lookahead(chunk[i]);
+	}
+	return simulate_trace(reader, policy);
+}
+
+#define REPLAY(Engine) replay<Engine, uint32_t>, replay<Engine, uint64_t>
+
+// Run a task, and with perf set record the hardware counters of the calling thread into sample
+template <typename Task>
+static void measured(bool perf, PerfSample& sample, Task task){
+	if(!perf){
+		task();
+		return;
+	}
+	PerfCounters task_counters;
+	task_counters.start();
+	task();
+	sample = task_counters.stop();
+}
 
 int main(int argc, char** argv){
-	vector<pair<std::string,Workload>> workloads({pair<std::string,Workload>("nonlocal",workload_nonlocal), pair<std::string, Workload>("80-20", workload_80_20), pair<std::string, Workload>("looping", workload_looping)}); 
-	vector<PageReplacementPolicy> policies({PRP_OPT, PRP_LRU, PRP_FIFO, PRP_RAND, PRP_CLOCK});
-	vector<int> access_sequence(NUM_ACCESSES, INVALID_PAGE);
-	for(auto w : workloads){
-		ofstream file(w.first + ".csv");
-		for(int memsize = MIN_MEM_SIZE; memsize <= MAX_MEM_SIZE; memsize += STEP){
-			file << memsize << ',';  
-			for(auto p : policies){
-				w.second(access_sequence, NUM_PAGES);
-				double correct = (double)p(access_sequence, memsize);
-				file << correct / NUM_ACCESSES * 100 << ',';
+	vector<pair<std::string,Workload<PageId>>> workloads({pair<std::string,Workload<PageId>>("nonlocal",workload_nonlocal<PageId>), pair<std::string, Workload<PageId>>("80-20", workload_80_20<PageId>), pair<std::string, Workload<PageId>>("looping", workload_looping<PageId>), pair<std::string, Workload<PageId>>("zipf", workload_zipf<PageId>)}); 
+	vector<PolicyColumn> policies({
+		{"OPT", NULL, OPT_hit_curve, replay_opt<uint32_t>, replay_opt<uint64_t>},
+		{"LRU", NULL, LRU_hit_curve, REPLAY(LruPolicy)},
+		{"FIFO", PRP_FIFO, NULL, REPLAY(FifoPolicy)},
+		{"RAND", PRP_RAND, NULL, replay_rand<uint32_t>, replay_rand<uint64_t>},
+		{"CLOCK", PRP_CLOCK, NULL, REPLAY(ClockPolicy)},
+		{"ARC", PRP_ARC, NULL, REPLAY(ArcPolicy)},
+		{"CAR", PRP_CAR, NULL, REPLAY(CarPolicy)},
+		{"CLOCK-Pro", PRP_CLOCK_PRO, NULL, REPLAY(ClockProPolicy)},
+		{"LIRS", PRP_LIRS, NULL, REPLAY(LirsPolicy)},
+		{"W-TinyLFU", PRP_WTINYLFU, NULL, REPLAY(WTinyLfuPolicy)}});
+
+	// Usage: prog4pagepolicy [--perf] [--trace FILE] [trace directory]
+	// With --perf, hardware counters of every task go to <workload>_perf.csv.
+	// With --trace, the binary trace FILE (see traceconv) is swept instead of
+	// the generated workloads, and the results go to <name>.hits.csv and
+	// friends, named after the file, which must not exist yet.
+	bool perf = false;
+	const char* trace_directory = "";
+	const char* trace_path = NULL;
+	for(int i = 1; i < argc; i++){
+		if(!strcmp(argv[i], "--perf")) perf = true;
+		else if(!strcmp(argv[i], "--trace")){
+			if(i + 1 == argc){
+				fprintf(stderr, "usage: %s [--perf] [--trace FILE] [trace directory]\n", argv[0]);
+				return 1;
+			}
+			trace_path = argv[++i];
+		}
+		else trace_directory = argv[i];
+	}
+	if(perf && !PerfCounters().available()){
+		fprintf(stderr, "perf events unavailable (see /proc/sys/kernel/perf_event_paranoid), not recording counters\n");
+		perf = false;
+	}
+
+	// One immutable trace per workload, made dense once and shared by every
+	// task of the sweep. With a directory argument, traces are kept there for
+	// reuse by later runs.
+	TraceCache cache(trace_directory);
+	vector<DenseWorkload> traces;
+	// Accesses in each workload, the denominator of its hit rates
+	vector<uint64_t> lengths;
+	// Results of workload w go to outputs[w] + ".csv" and so on
+	vector<std::string> outputs;
+	TraceReader reader;
+	bool wide_ids = false;
+	if(trace_path){
+		if(!reader.open(trace_path)){
+			fprintf(stderr, "%s: not a readable trace file\n", trace_path);
+			return 1;
+		}
+		std::string name(trace_path);
+		name = name.substr(name.find_last_of('/') + 1);
+		name = name.substr(0, name.rfind(".trace"));
+		workloads.assign(1, pair<std::string, Workload<PageId>>(name, NULL));
+		lengths.push_back(reader.size());
+		// Engines reserve the largest id of their PageId type, so a 32-bit
+		// trace using it is replayed with 64-bit ids, and a 64-bit one cannot
+		// be replayed at all
+		const uint64_t largest = trace_largest_page(reader);
+		if(largest == UINT64_MAX){
+			fprintf(stderr, "%s: page id %llu is reserved by every policy, cannot replay this trace\n", trace_path, (unsigned long long)largest);
+			return 1;
+		}
+		wide_ids = reader.width() == 8 || largest == UINT32_MAX;
+		// The trace may sit next to the file it was converted from, or next to
+		// the results of a sweep, so never write over anything already there
+		outputs.push_back(name + ".hits");
+		const char* suffixes[] = {".csv", "_perf.csv", "_plot.png"};
+		for(const char* suffix : suffixes){
+			std::string output = outputs[0] + suffix;
+			if(access(output.c_str(), F_OK) == 0){
+				fprintf(stderr, "%s: already exists, not overwriting it\n", output.c_str());
+				return 1;
+			}
+		}
+	}
+	else{
+		for(auto w : workloads){
+			traces.emplace_back(cache.get(w.first, w.second, NUM_ACCESSES, NUM_PAGES, WORKLOAD_SEED));
+			lengths.push_back(NUM_ACCESSES);
+			outputs.push_back(w.first);
+		}
+	}
+
+	// hits[w][p][m] is the hit count of policy p on workload w with the m-th memory size
+	vector<vector<vector<uint64_t>>> hits(workloads.size(), vector<vector<uint64_t>>(policies.size(), vector<uint64_t>(NUM_MEM_SIZES)));
+	// counters[w][p][m] likewise, a hit curve only fills m = 0
+	vector<vector<vector<PerfSample>>> counters(workloads.size(), vector<vector<PerfSample>>(policies.size(), vector<PerfSample>(NUM_MEM_SIZES)));
+	{
+		// Each (workload, policy, memsize) cell is an independent task, except
+		// that a hit curve fills a whole row of memory sizes in one task
+		TaskPool pool;
+		for(unsigned int w = 0; w < workloads.size(); w++){
+			for(unsigned int p = 0; p < policies.size(); p++){
+				if(trace_path){
+					for(int m = 0; m < NUM_MEM_SIZES; m++){
+						pool.submit([&reader, &hits, &counters, &policies, perf, wide_ids, w, p, m](){
+							const unsigned int memsize = MIN_MEM_SIZE + m * STEP;
+							measured(perf, counters[w][p][m], [&](){
+								hits[w][p][m] = wide_ids ? policies[p].replay64(reader, memsize) : policies[p].replay32(reader, memsize);
+							});
+						});
+					}
+					continue;
+				}
+				if(policies[p].curve){
+					pool.submit([&traces, &hits, &counters, &policies, perf, w, p](){
+						vector<int> curve;
+						measured(perf, counters[w][p][0], [&](){ curve = policies[p].curve(traces[w], MAX_MEM_SIZE); });
+						for(int m = 0; m < NUM_MEM_SIZES; m++){
+							hits[w][p][m] = curve[MIN_MEM_SIZE + m * STEP];
+						}
+					});
+					continue;
+				}
+				for(int m = 0; m < NUM_MEM_SIZES; m++){
+					pool.submit([&traces, &hits, &counters, &policies, perf, w, p, m](){
+						measured(perf, counters[w][p][m], [&](){ hits[w][p][m] = policies[p].run(traces[w], MIN_MEM_SIZE + m * STEP); });
+					});
+				}
+			}
+		}
+		pool.wait();
+	}
+
+	// Write the results in a fixed order, whatever order the tasks finished in
+	for(unsigned int w = 0; w < workloads.size(); w++){
+		ofstream file(outputs[w] + ".csv");
+		for(int m = 0; m < NUM_MEM_SIZES; m++){
+			file << MIN_MEM_SIZE + m * STEP << ',';  
+			for(unsigned int p = 0; p < policies.size(); p++){
+				double correct = (double)hits[w][p][m];
+				file << correct / lengths[w] * 100 << ',';
 			}
 			file.seekp(-1, std::ios_base::cur); //Overwrite the hanging comma with the newline coming up
 			file << std::endl;
 		}
 		file.close();
+		if(perf){
+			ofstream perf_file(outputs[w] + "_perf.csv");
+			perf_file << "policy,memsize";
+			for(int e = 0; e < NUM_PERF_EVENTS; e++){
+				perf_file << ',' << PerfCounters::name((PerfEvent)e) << "_per_access";
+			}
+			perf_file << std::endl;
+			for(unsigned int p = 0; p < policies.size(); p++){
+				// A hit curve is a single run covering every memory size
+				bool curve = policies[p].curve && !trace_path;
+				int rows = curve ? 1 : NUM_MEM_SIZES;
+				for(int m = 0; m < rows; m++){
+					perf_file << policies[p].name << ',';
+					if(curve) perf_file << "all";
+					else perf_file << MIN_MEM_SIZE + m * STEP;
+					for(int e = 0; e < NUM_PERF_EVENTS; e++){
+						double count = counters[w][p][m].counts[e];
+						perf_file << ',';
+						if(count < 0) perf_file << "NA";
+						else perf_file << count / lengths[w];
+					}
+					perf_file << std::endl;
+				}
+			}
+		}
 		std::ostringstream cmd;
-		cmd << "gnuplot -e \" title=\'" << w.first << "\'\" -e \" input_filename=\'" << w.first << ".csv\'\" plot_hit_rates.plt > " << w.first << "_plot.png";
+		cmd << "gnuplot -e \" title=\'" << workloads[w].first << "\'\" -e \" input_filename=\'" << outputs[w] << ".csv\'\" plot_hit_rates.plt > " << outputs[w] << "_plot.png";
 		system(cmd.str().data()); 
 	} 
 }
-
@@ -0,0 +1,18 @@
+#include <vector>
+#include "remap.hpp"
+
+uint32_t remap_dense(const uint64_t* pages, size_t n, uint32_t* out) {
+    PageRemapper remapper;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = remapper.map(pages[i]);
+    }
+    return remapper.size();
+}
+
+uint32_t remap_dense(const uint32_t* pages, size_t n, uint32_t* out) {
+    PageRemapper remapper;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = remapper.map(pages[i]);
+    }
+    return remapper.size();
+}
@@ -0,0 +1,43 @@
+#pragma once
+#ifndef REMAP_HPP_
+#define REMAP_HPP_
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "flat_map.hpp"
+
+/*!
+ *  \brief Renames arbitrary page ids to dense ids 0..K-1.
+ *
+ *  Ids are handed out in order of first appearance, so a trace over K distinct
+ *  pages becomes a trace over 0..K-1 and policies can keep their per-page state
+ *  in flat arrays instead of hash tables. Works incrementally, for streams.
+ *  The largest 64-bit id is reserved by the underlying FlatHashMap.
+ */
+class PageRemapper {
+public:
+    // Dense id of page, assigning the next free one on first sight
+    uint32_t map(uint64_t page) {
+        return *ids_.emplace(page, static_cast<uint32_t>(ids_.size())).first;
+    }
+
+    // Number of distinct pages seen so far
+    uint32_t size() const { return ids_.size(); }
+
+private:
+    FlatHashMap<uint64_t, uint32_t> ids_;
+};
+
+/*!
+ *  \brief Remap a whole trace to dense page ids in one pass.
+ *
+ *  \param pages Page ids to remap
+ *  \param n Number of page ids
+ *  \param out Receives the n dense ids, may be the same array as pages
+ *  \return Number of distinct pages K, the dense ids are 0..K-1
+ */
+uint32_t remap_dense(const uint64_t* pages, size_t n, uint32_t* out);
+uint32_t remap_dense(const uint32_t* pages, size_t n, uint32_t* out);
+
+#endif /* end of include guard: REMAP_HPP_ */
@@ -0,0 +1,61 @@
+#pragma once
+#ifndef RNG_HPP_
+#define RNG_HPP_
+
+#include <cstdint>
+
+/*!
+ *  \brief xoshiro256** pseudo random number generator.
+ *
+ *  Small and fast, with an explicit 64 bit seed so that runs are reproducible.
+ *  The seed is expanded into the 256 bit state with splitmix64, as recommended
+ *  by the authors of xoshiro.
+ */
+class Xoshiro256 {
+public:
+    explicit Xoshiro256(uint64_t seed) {
+        for (uint64_t& word : state_) {
+            seed += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next() {
+        const uint64_t result = rotl(state_[1] * 5, 7) * 9;
+        const uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+        return result;
+    }
+
+    // Uniform integer in [0, bound), by Lemire's multiply-shift (bias < 2^-32)
+    uint32_t below(uint32_t bound) {
+        return static_cast<uint32_t>(((next() >> 32) * bound) >> 32);
+    }
+
+    // Uniform integer in [0, bound) for 64 bit bounds, with a 128 bit product
+    uint64_t below64(uint64_t bound) {
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(next()) * bound) >> 64);
+    }
+
+    // Uniform double in [0, 1) with 53 random bits
+    double uniform() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t state_[4];
+};
+
+#endif /* end of include guard: RNG_HPP_ */
@@ -0,0 +1,103 @@
+#include <thread>
+#include <mutex>
+#include "scheduler.hpp"
+
+TaskPool::TaskPool(unsigned int threads)
+    : nextQueue_(0), queued_(0), pending_(0), stopping_(false) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+    for (unsigned int i = 0; i < threads; i++) {
+        queues_.emplace_back(new Queue());
+    }
+    for (unsigned int i = 0; i < threads; i++) {
+        threads_.emplace_back(&TaskPool::run, this, i);
+    }
+}
+
+TaskPool::~TaskPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+void TaskPool::submit(Task task) {
+    Queue& queue = *queues_[nextQueue_];
+    nextQueue_ = (nextQueue_ + 1) % queues_.size();
+    {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        queued_++;
+        pending_++;
+    }
+    wake_.notify_one();
+}
+
+void TaskPool::wait() {
+    std::unique_lock<std::mutex> guard(mutex_);
+    idle_.wait(guard, [this] { return pending_ == 0; });
+}
+
+/*
+ * A worker first claims one of the queued tasks under the pool mutex, which
+ * guarantees that some deque holds a task for it, and only then searches the
+ * deques: its own from the back, the others from the front.
+ */
+TaskPool::Task TaskPool::take(unsigned int self) {
+    for (;;) {
+        for (unsigned int i = 0; i < queues_.size(); i++) {
+            const bool own = i == 0;
+            Queue& queue = *queues_[(self + i) % queues_.size()];
+            std::lock_guard<std::mutex> guard(queue.lock);
+            if (!queue.tasks.empty()) {
+                Task task;
+                if (own) {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                } else {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+                return task;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+void TaskPool::run(unsigned int self) {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> guard(mutex_);
+            wake_.wait(guard, [this] { return queued_ > 0 || stopping_; });
+            if (queued_ == 0) {
+                return;
+            }
+            queued_--;
+        }
+
+        Task task = take(self);
+        task();
+
+        bool done;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            done = --pending_ == 0;
+        }
+        if (done) {
+            idle_.notify_all();
+        }
+    }
+}
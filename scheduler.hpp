@@ -0,0 +1,56 @@
+#pragma once
+#ifndef SCHEDULER_HPP_
+#define SCHEDULER_HPP_
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/*!
+ *  \brief Fixed-size thread pool with work stealing.
+ *
+ *  Every worker owns a deque of tasks. Submitted tasks are dealt round-robin
+ *  to the deques; a worker takes its newest task first and, when its own deque
+ *  is empty, steals the oldest task of another worker. Tasks must not throw.
+ */
+class TaskPool {
+public:
+    typedef std::function<void()> Task;
+
+    // threads == 0 uses one thread per hardware thread
+    explicit TaskPool(unsigned int threads = 0);
+    // Waits for all submitted tasks, then stops the workers
+    ~TaskPool();
+
+    void submit(Task task);
+    // Block until every task submitted so far has finished
+    void wait();
+
+    unsigned int size() const { return threads_.size(); }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    void run(unsigned int self);
+    Task take(unsigned int self);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    unsigned int nextQueue_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    size_t queued_;   // tasks in the deques not yet claimed by a worker
+    size_t pending_;  // tasks submitted and not yet finished
+    bool stopping_;
+};
+
+#endif /* end of include guard: SCHEDULER_HPP_ */
@@ -0,0 +1,94 @@
+#pragma once
+#ifndef SLOT_INDEX_HPP_
+#define SLOT_INDEX_HPP_
+
+#include <vector>
+#include <algorithm>
+#include "flat_map.hpp"
+#include "find_page.hpp"
+
+/*!
+ *  \brief Index from resident page to the frame holding it.
+ *
+ *  Small memories keep the page of every slot in one contiguous array that is
+ *  searched with the SIMD find_page kernel, which beats hashing while the
+ *  array fits in a few cache lines. Larger memories use a FlatHashMap sized for
+ *  the memory, so it never grows or allocates while simulating. When the pages
+ *  are known to be dense ids below some universe size, the index is instead a
+ *  flat array indexed by page, with no hashing at all. Templated on the page id
+ *  type, uint32_t or uint64_t.
+ */
+template <typename PageId>
+class SlotIndex {
+public:
+    static const unsigned int NOT_FOUND = static_cast<unsigned int>(-1);
+    // Largest capacity searched by scanning instead of hashing. Scanning wins
+    // up to about this many frames on an AVX2 machine, for either id width,
+    // mostly by sparing the mispredicted probe loops of the hash map.
+    static const unsigned int SCAN_CAPACITY = 128;
+
+    // A non-zero universe selects the flat array for pages 0..universe-1
+    explicit SlotIndex(unsigned int capacity, unsigned int universe = 0)
+        : mode_(universe > 0 ? DENSE : capacity <= SCAN_CAPACITY ? SCAN : HASH),
+          slots_(universe, static_cast<unsigned int>(NOT_FOUND)),
+          pages_(mode_ == SCAN ? capacity : 0, PageId(EMPTY)),
+          map_(mode_ == HASH ? capacity : 0) {
+    }
+
+    void clear() {
+        switch (mode_) {
+        case DENSE: std::fill(slots_.begin(), slots_.end(), static_cast<unsigned int>(NOT_FOUND)); break;
+        case SCAN: std::fill(pages_.begin(), pages_.end(), PageId(EMPTY)); break;
+        case HASH: map_.clear(); break;
+        }
+    }
+
+    unsigned int find(PageId page) const {
+        if (mode_ == DENSE) return slots_[page];
+        if (mode_ == SCAN) {
+            const size_t slot = find_page(pages_.data(), pages_.size(), page);
+            return slot < pages_.size() ? slot : NOT_FOUND;
+        }
+        const unsigned int* slot = map_.find(page);
+        return slot ? *slot : NOT_FOUND;
+    }
+
+    // Hint that page is about to be looked up
+    void prefetch(PageId page) const {
+        if (mode_ == DENSE) __builtin_prefetch(&slots_[page]);
+        else if (mode_ == HASH) map_.prefetch(page);
+    }
+
+    // Page must not already be present, and slot must be below the capacity
+    void insert(PageId page, unsigned int slot) {
+        switch (mode_) {
+        case DENSE: slots_[page] = slot; break;
+        case SCAN: pages_[slot] = page; break;
+        case HASH: map_.emplace(page, slot); break;
+        }
+    }
+
+    void erase(PageId page) {
+        switch (mode_) {
+        case DENSE: slots_[page] = NOT_FOUND; break;
+        case SCAN: {
+            const unsigned int slot = find(page);
+            if (slot != NOT_FOUND) pages_[slot] = EMPTY;
+            break;
+        }
+        case HASH: map_.erase(page); break;
+        }
+    }
+
+private:
+    enum Mode { DENSE, SCAN, HASH };
+    // Marks unused slots of the scanned array
+    static const PageId EMPTY = FlatHashMap<PageId, unsigned int>::EMPTY;
+
+    Mode mode_;
+    std::vector<unsigned int> slots_;
+    std::vector<PageId> pages_;
+    FlatHashMap<PageId, unsigned int> map_;
+};
+
+#endif /* end of include guard: SLOT_INDEX_HPP_ */
@@ -0,0 +1,54 @@
+#include <vector>
+#include <string>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "trace_cache.hpp"
+#include "trace_file.hpp"
+
+using std::vector;
+using std::string;
+
+TraceCache::TraceCache(const string& directory) : directory_(directory) {
+    if (!directory_.empty()) {
+        mkdir(directory_.c_str(), 0777); // Fails harmlessly if it already exists
+    }
+}
+
+const vector<uint32_t>& TraceCache::get(const string& name, Workload<uint32_t> generator,
+        size_t length, uint64_t num_pages, uint64_t seed) {
+    std::ostringstream key;
+    key << name << "-v" << WORKLOAD_VERSION << '-' << length << '-' << num_pages << '-' << seed;
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    std::unique_ptr<vector<uint32_t>>& trace = traces_[key.str()];
+    if (trace) {
+        return *trace;
+    }
+
+    trace.reset(new vector<uint32_t>(length));
+    const string path = directory_.empty() ? string() : directory_ + "/" + key.str() + ".trace";
+    if (path.empty() || !load(path, length, *trace)) {
+        generator(*trace, num_pages, seed);
+        if (!path.empty()) {
+            save(path, *trace);
+        }
+    }
+    return *trace;
+}
+
+bool TraceCache::load(const string& path, size_t length, vector<uint32_t>& trace) const {
+    TraceReader reader;
+    if (!reader.open(path) || reader.size() != length) {
+        return false;
+    }
+    TraceFileStream<uint32_t> stream(reader);
+    return stream.next(trace.data(), length) == length;
+}
+
+void TraceCache::save(const string& path, const vector<uint32_t>& trace) const {
+    TraceWriter writer;
+    if (!(writer.open(path) && writer.write(trace.data(), trace.size()) && writer.close())) {
+        unlink(path.c_str()); // Never leave a partial trace behind for the next run
+    }
+}
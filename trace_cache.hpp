@@ -0,0 +1,51 @@
+#pragma once
+#ifndef TRACE_CACHE_HPP_
+#define TRACE_CACHE_HPP_
+
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include "workloads.hpp"
+
+/*!
+ *  \brief Materializes each workload trace once and shares it read-only.
+ *
+ *  Traces are keyed by generator name, length, page count and seed, so every
+ *  policy and memory size of a sweep sees the very same accesses. When given a
+ *  directory, traces are also saved there as binary trace files and loaded back
+ *  by later runs instead of being generated again; the file names also carry
+ *  WORKLOAD_VERSION, so a build whose generators changed never loads stale
+ *  traces. Safe to use from several threads at once.
+ *  Generated workloads span few pages, so traces are kept with 32-bit ids.
+ */
+class TraceCache {
+public:
+    // An empty directory keeps traces in memory only
+    explicit TraceCache(const std::string& directory = "");
+
+    /*!
+     *  \brief Get a trace, generating or loading it on first use.
+     *
+     *  \param name Name of the generator, part of the cache key
+     *  \param generator Workload generator to run if the trace is not cached
+     *  \param length Number of accesses in the trace
+     *  \param num_pages Number of addressable pages
+     *  \param seed Seed given to the generator
+     *  \return The trace, valid for the lifetime of the cache
+     */
+    const std::vector<uint32_t>& get(const std::string& name, Workload<uint32_t> generator,
+        size_t length, uint64_t num_pages, uint64_t seed);
+
+private:
+    bool load(const std::string& path, size_t length, std::vector<uint32_t>& trace) const;
+    void save(const std::string& path, const std::vector<uint32_t>& trace) const;
+
+    std::string directory_;
+    std::map<std::string, std::unique_ptr<std::vector<uint32_t>>> traces_;
+    std::mutex mutex_;
+};
+
+#endif /* end of include guard: TRACE_CACHE_HPP_ */
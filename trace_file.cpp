@@ -0,0 +1,285 @@
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "trace_file.hpp"
+#include "policies.hpp"
+
+using std::string;
+
+static const char TRACE_MAGIC[4] = {'P', 'G', 'T', 'F'};
+static const uint16_t TRACE_VERSION = 1;
+
+struct TraceHeader {
+    char magic[4];
+    uint16_t version;
+    uint8_t width;
+    uint8_t encoding;
+    uint64_t count;
+};
+
+// Bytes re-encoded at a time by the writer, and the longest varint
+static const size_t ENCODE_BUFFER = 1 << 16;
+static const size_t MAX_VARINT = 10;
+
+static uint64_t zigzag(uint64_t delta) {
+    return (delta << 1) ^ (0 - (delta >> 63));
+}
+
+static uint64_t unzigzag(uint64_t value) {
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+TraceWriter::TraceWriter()
+    : file_(NULL), width_(4), encoding_(TRACE_RAW), count_(0), previous_(0), ok_(false) {
+}
+
+TraceWriter::~TraceWriter() {
+    close();
+}
+
+bool TraceWriter::open(const string& path, unsigned int width, TraceEncoding encoding) {
+    close();
+    if (width != 4 && width != 8) {
+        return false;
+    }
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) {
+        return false;
+    }
+    width_ = width;
+    encoding_ = encoding;
+    count_ = 0;
+    previous_ = 0;
+    // Header is rewritten with the final count on close
+    TraceHeader header = TraceHeader();
+    ok_ = fwrite(&header, sizeof(header), 1, file_) == 1;
+    return ok_;
+}
+
+bool TraceWriter::write(const uint32_t* pages, size_t n) {
+    return append(pages, n);
+}
+
+bool TraceWriter::write(const uint64_t* pages, size_t n) {
+    return append(pages, n);
+}
+
+template <typename PageId>
+bool TraceWriter::append(const PageId* pages, size_t n) {
+    if (!file_ || !ok_) {
+        return false;
+    }
+    count_ += n;
+    if (encoding_ == TRACE_RAW && width_ == sizeof(PageId)) {
+        ok_ = fwrite(pages, sizeof(PageId), n, file_) == n;
+        return ok_;
+    }
+
+    // Re-encode through a small buffer: widened or narrowed raw ids, or varints
+    unsigned char buffer[ENCODE_BUFFER];
+    size_t used = 0;
+    for (size_t i = 0; i < n; i++) {
+        const uint64_t page = width_ == 4 ? static_cast<uint32_t>(pages[i]) : static_cast<uint64_t>(pages[i]);
+        if (encoding_ == TRACE_RAW) {
+            if (width_ == 4) {
+                const uint32_t narrow = static_cast<uint32_t>(page);
+                memcpy(buffer + used, &narrow, 4);
+            } else {
+                memcpy(buffer + used, &page, 8);
+            }
+            used += width_;
+        } else {
+            uint64_t value = zigzag(page - previous_);
+            previous_ = page;
+            while (value >= 0x80) {
+                buffer[used++] = static_cast<unsigned char>(value) | 0x80;
+                value >>= 7;
+            }
+            buffer[used++] = static_cast<unsigned char>(value);
+        }
+        if (used > sizeof(buffer) - MAX_VARINT) {
+            ok_ = ok_ && fwrite(buffer, 1, used, file_) == used;
+            used = 0;
+        }
+    }
+    ok_ = ok_ && fwrite(buffer, 1, used, file_) == used;
+    return ok_;
+}
+
+bool TraceWriter::close() {
+    if (!file_) {
+        return ok_;
+    }
+    TraceHeader header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.width = width_;
+    header.encoding = encoding_;
+    header.count = count_;
+    ok_ = ok_ && fseek(file_, 0, SEEK_SET) == 0
+        && fwrite(&header, sizeof(header), 1, file_) == 1;
+    ok_ = fclose(file_) == 0 && ok_;
+    file_ = NULL;
+    return ok_;
+}
+
+TraceReader::TraceReader()
+    : map_(MAP_FAILED), mapSize_(0), data_(NULL), dataSize_(0), count_(0),
+      width_(4), encoding_(TRACE_RAW) {
+}
+
+TraceReader::~TraceReader() {
+    close();
+}
+
+bool TraceReader::open(const string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(TraceHeader)) {
+        ::close(fd);
+        return false;
+    }
+    mapSize_ = info.st_size;
+    map_ = mmap(NULL, mapSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map_ == MAP_FAILED) {
+        return false;
+    }
+    madvise(map_, mapSize_, MADV_SEQUENTIAL);
+
+    TraceHeader header;
+    memcpy(&header, map_, sizeof(header));
+    data_ = static_cast<const unsigned char*>(map_) + sizeof(header);
+    dataSize_ = mapSize_ - sizeof(header);
+    count_ = header.count;
+    width_ = header.width;
+    encoding_ = static_cast<TraceEncoding>(header.encoding);
+
+    const bool valid = memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) == 0
+        && header.version == TRACE_VERSION
+        && (width_ == 4 || width_ == 8)
+        && (encoding_ == TRACE_RAW || encoding_ == TRACE_DELTA_VARINT)
+        && (encoding_ != TRACE_RAW || dataSize_ / width_ >= count_);
+    if (!valid) {
+        close();
+    }
+    return valid;
+}
+
+void TraceReader::close() {
+    if (map_ != MAP_FAILED) {
+        munmap(map_, mapSize_);
+    }
+    map_ = MAP_FAILED;
+    mapSize_ = 0;
+    data_ = NULL;
+    dataSize_ = 0;
+    count_ = 0;
+}
+
+PageSpan<uint32_t> TraceReader::pages32() const {
+    PageSpan<uint32_t> span = {NULL, 0};
+    if (encoding_ == TRACE_RAW && width_ == 4 && data_) {
+        span.data = reinterpret_cast<const uint32_t*>(data_);
+        span.size = count_;
+    }
+    return span;
+}
+
+PageSpan<uint64_t> TraceReader::pages64() const {
+    PageSpan<uint64_t> span = {NULL, 0};
+    if (encoding_ == TRACE_RAW && width_ == 8 && data_) {
+        span.data = reinterpret_cast<const uint64_t*>(data_);
+        span.size = count_;
+    }
+    return span;
+}
+
+template <typename PageId>
+TraceFileStream<PageId>::TraceFileStream(const TraceReader& reader)
+    : reader_(reader), position_(0), offset_(0), previous_(0) {
+}
+
+template <typename PageId>
+size_t TraceFileStream<PageId>::next(PageId* out, size_t n) {
+    n = std::min<uint64_t>(n, reader_.count_ - position_);
+    if (reader_.encoding_ == TRACE_RAW) {
+        const unsigned char* at = reader_.data_ + position_ * reader_.width_;
+        for (size_t i = 0; i < n; i++, at += reader_.width_) {
+            uint64_t page = 0;
+            memcpy(&page, at, reader_.width_);
+            out[i] = static_cast<PageId>(page);
+        }
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            uint64_t value = 0;
+            unsigned int shift = 0;
+            unsigned char byte;
+            do {
+                if (offset_ == reader_.dataSize_ || shift >= 7 * MAX_VARINT) {
+                    // Truncated file, or a varint longer than any id, so the
+                    // data is corrupt: end the stream early for good
+                    offset_ = reader_.dataSize_;
+                    position_ += i;
+                    return i;
+                }
+                byte = reader_.data_[offset_++];
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+            previous_ += unzigzag(value);
+            out[i] = static_cast<PageId>(previous_);
+        }
+    }
+    position_ += n;
+    return n;
+}
+
+uint64_t trace_largest_page(const TraceReader& reader) {
+    uint64_t largest = 0;
+    const PageSpan<uint32_t> span32 = reader.pages32();
+    const PageSpan<uint64_t> span64 = reader.pages64();
+    if (span32.size > 0) {
+        largest = *std::max_element(span32.begin(), span32.end());
+    } else if (span64.size > 0) {
+        largest = *std::max_element(span64.begin(), span64.end());
+    } else {
+        TraceFileStream<uint64_t> stream(reader);
+        std::vector<uint64_t> chunk(ENCODE_BUFFER);
+        size_t n;
+        while ((n = stream.next(chunk.data(), chunk.size())) > 0) {
+            largest = std::max(largest, *std::max_element(chunk.begin(), chunk.begin() + n));
+        }
+    }
+    return largest;
+}
+
+template <typename PageId>
+uint64_t simulate_trace(const TraceReader& reader, Policy<PageId>& policy) {
+    PageSpan<PageId> span;
+    if constexpr (sizeof(PageId) == 4) {
+        span = reader.pages32();
+    } else {
+        span = reader.pages64();
+    }
+    if (span.data) {
+        return policy.access_batch(span.data, span.size, NULL);
+    }
+    TraceFileStream<PageId> stream(reader);
+    return simulate_stream(stream, policy);
+}
+
+template class TraceFileStream<uint32_t>;
+template class TraceFileStream<uint64_t>;
+template uint64_t simulate_trace(const TraceReader&, Policy<uint32_t>&);
+template uint64_t simulate_trace(const TraceReader&, Policy<uint64_t>&);
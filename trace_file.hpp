@@ -0,0 +1,142 @@
+#pragma once
+#ifndef TRACE_FILE_HPP_
+#define TRACE_FILE_HPP_
+
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include "workloads.hpp"
+
+/*
+ * Binary trace file layout, in host byte order:
+ *
+ *   offset 0   char[4]  magic "PGTF"
+ *   offset 4   uint16   version (1)
+ *   offset 6   uint8    page id width in bytes (4 or 8)
+ *   offset 7   uint8    encoding (TRACE_RAW or TRACE_DELTA_VARINT)
+ *   offset 8   uint64   number of accesses
+ *   offset 16  data
+ *
+ * Raw data is the packed array of page ids, so a mapped file can be used in
+ * place. Delta-varint data stores the difference to the previous page id,
+ * zigzag encoded as LEB128, which shrinks traces with locality several fold.
+ */
+enum TraceEncoding {
+    TRACE_RAW = 0,
+    TRACE_DELTA_VARINT = 1
+};
+
+// Read-only view of a run of page ids, used in place
+template <typename PageId>
+struct PageSpan {
+    const PageId* data;
+    size_t size;
+
+    const PageId* begin() const { return data; }
+    const PageId* end() const { return data + size; }
+};
+
+/*!
+ *  \brief Writes a binary trace file incrementally.
+ *
+ *  Accesses are appended in any number of calls, the access count in the
+ *  header is filled in by close(). Methods return false on I/O errors.
+ */
+class TraceWriter {
+public:
+    TraceWriter();
+    ~TraceWriter();
+
+    bool open(const std::string& path, unsigned int width = 4, TraceEncoding encoding = TRACE_RAW);
+    bool write(const uint32_t* pages, size_t n);
+    bool write(const uint64_t* pages, size_t n);
+    bool close();
+
+private:
+    template <typename PageId>
+    bool append(const PageId* pages, size_t n);
+
+    FILE* file_;
+    unsigned int width_;
+    TraceEncoding encoding_;
+    uint64_t count_;
+    uint64_t previous_;
+    bool ok_;
+};
+
+/*!
+ *  \brief Memory-maps a binary trace file for zero-copy replay.
+ *
+ *  Raw traces are exposed directly as a span over the mapping, so opening a
+ *  multi-GB trace costs nothing until pages are touched. Delta-varint traces
+ *  are decoded on the fly through TraceFileStream.
+ */
+class TraceReader {
+public:
+    TraceReader();
+    ~TraceReader();
+
+    bool open(const std::string& path);
+    void close();
+
+    uint64_t size() const { return count_; }
+    unsigned int width() const { return width_; }
+    TraceEncoding encoding() const { return encoding_; }
+
+    // The page ids in place, empty unless the trace is raw with that width
+    PageSpan<uint32_t> pages32() const;
+    PageSpan<uint64_t> pages64() const;
+
+private:
+    template <typename PageId>
+    friend class TraceFileStream;
+
+    TraceReader(const TraceReader&);
+    TraceReader& operator=(const TraceReader&);
+
+    void* map_;
+    size_t mapSize_;
+    const unsigned char* data_;
+    size_t dataSize_;
+    uint64_t count_;
+    unsigned int width_;
+    TraceEncoding encoding_;
+};
+
+// Decodes the accesses of any open trace, as a workload stream. Ids wider
+// than PageId are truncated.
+template <typename PageId>
+class TraceFileStream : public WorkloadStream<PageId> {
+public:
+    explicit TraceFileStream(const TraceReader& reader);
+    size_t next(PageId* out, size_t n) override;
+
+private:
+    const TraceReader& reader_;
+    uint64_t position_;  // accesses produced so far
+    size_t offset_;      // byte offset into varint data
+    uint64_t previous_;
+};
+
+/*!
+ *  \brief Finds the largest page id of a trace.
+ *
+ *  Every engine reserves the largest id of its PageId type, so a trace using
+ *  that id has to be replayed with wider ids, or not at all.
+ *
+ *  \return Largest page id accessed, zero for an empty trace
+ */
+uint64_t trace_largest_page(const TraceReader& reader);
+
+/*!
+ *  \brief Replays a whole trace file through a policy.
+ *
+ *  Raw traces whose width matches PageId are passed to the policy straight
+ *  from the mapping, other traces are decoded a chunk at a time.
+ *
+ *  \return Number of hits during the trace
+ */
+template <typename PageId>
+uint64_t simulate_trace(const TraceReader& reader, Policy<PageId>& policy);
+
+#endif /* end of include guard: TRACE_FILE_HPP_ */
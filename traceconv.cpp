@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <charconv>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "trace_file.hpp"
+#include "scheduler.hpp"
+#include "remap.hpp"
+
+using std::vector;
+using std::string;
+
+// Input bytes parsed per round; each round is split between the threads
+#define WINDOW_BYTES (64 << 20)
+#define DEFAULT_PAGE_SIZE 4096
+#define SECTOR_SIZE 512
+// Page ids carry the device number above this bit, so that the same block
+// on different volumes is a different page
+#define DEVICE_SHIFT 48
+#define MAX_DEVICE ((1 << (64 - DEVICE_SHIFT)) - 1)
+// Longest request converted, in pages; longer ones are taken for corrupt
+// sizes rather than expanded into billions of accesses
+#define MAX_REQUEST_PAGES (1 << 20)
+// Every policy engine reserves the largest page id, so it is never written
+#define RESERVED_PAGE UINT64_MAX
+
+/*
+ * Supported block trace layouts, one request per line:
+ *
+ *   msr  MSR Cambridge CSV: Timestamp,Hostname,DiskNumber,Type,Offset,Size,ResponseTime
+ *        with Offset and Size in bytes
+ *   spc  SPC / UMass CSV: ASU,LBA,Size,Opcode,Timestamp
+ *        with LBA in 512 byte sectors and Size in bytes
+ *   arc  ARC paper traces: StartBlock NumBlocks Ignored RequestNumber
+ *        with blocks of 512 bytes, separated by spaces, all on device 0
+ *
+ * The device (DiskNumber or ASU) is folded into the page id, unless a single
+ * device is selected.
+ */
+enum TraceFormat { FORMAT_MSR, FORMAT_SPC, FORMAT_ARC };
+
+struct ParseOptions {
+	TraceFormat format;
+	uint64_t page_size;
+	bool one_device;  // keep only the requests of device, with plain page ids
+	uint64_t device;
+};
+
+struct Chunk {
+	const char* begin;
+	const char* end;
+	vector<uint64_t> pages;
+	uint64_t skipped;
+	uint64_t other_devices;  // requests dropped for being on another device
+};
+
+// Parse the unsigned integer starting at p, advancing p past it
+static bool parse_number(const char*& p, const char* end, uint64_t& value){
+	std::from_chars_result result = std::from_chars(p, end, value);
+	if(result.ec != std::errc()) return false;
+	p = result.ptr;
+	return true;
+}
+
+// Advance p past count separator characters, false if the line ends first
+static bool skip_fields(const char*& p, const char* end, char separator, int count){
+	for(; count > 0; count--){
+		p = (const char*)memchr(p, separator, end - p);
+		if(!p) return false;
+		p++;
+	}
+	return true;
+}
+
+static void skip_spaces(const char*& p, const char* end){
+	while(p < end && (*p == ' ' || *p == '\t')) p++;
+}
+
+/*\brief Extract the device and byte range of the request on one line
+ *
+ * return false for headers, blank and malformed lines, and for ranges too
+ * far out to be addressed in bytes
+ */
+static bool parse_line(TraceFormat format, const char* p, const char* end, uint64_t& device, uint64_t& offset, uint64_t& length){
+	switch(format){
+	case FORMAT_MSR:
+		return skip_fields(p, end, ',', 2) && parse_number(p, end, device)
+			&& skip_fields(p, end, ',', 2) && parse_number(p, end, offset)
+			&& skip_fields(p, end, ',', 1) && parse_number(p, end, length);
+	case FORMAT_SPC:
+		if(!(parse_number(p, end, device)
+			&& skip_fields(p, end, ',', 1) && parse_number(p, end, offset)
+			&& skip_fields(p, end, ',', 1) && parse_number(p, end, length))) return false;
+		return !__builtin_mul_overflow(offset, SECTOR_SIZE, &offset);
+	case FORMAT_ARC:
+		device = 0;
+		skip_spaces(p, end);
+		if(!parse_number(p, end, offset)) return false;
+		skip_spaces(p, end);
+		if(!parse_number(p, end, length)) return false;
+		return !__builtin_mul_overflow(offset, SECTOR_SIZE, &offset)
+			&& !__builtin_mul_overflow(length, SECTOR_SIZE, &length);
+	}
+	return false;
+}
+
+/*\brief Append the pages one request touches
+ *
+ * return false, appending nothing, for requests ending past the last byte,
+ * longer than MAX_REQUEST_PAGES, or whose device and pages do not fit beside
+ * each other in a page id other than RESERVED_PAGE
+ */
+static bool add_request(const ParseOptions& options, uint64_t device, uint64_t offset, uint64_t length, vector<uint64_t>& pages){
+	if(length > 0 && offset + (length - 1) < offset) return false;
+	uint64_t first = offset / options.page_size;
+	uint64_t last = length > 0 ? (offset + length - 1) / options.page_size : first;
+	if(last - first >= MAX_REQUEST_PAGES) return false;
+	uint64_t base = 0;
+	if(!options.one_device){
+		if(device > MAX_DEVICE || last >> DEVICE_SHIFT != 0) return false;
+		base = device << DEVICE_SHIFT;
+	}
+	if((base | last) == RESERVED_PAGE) return false;
+	for(uint64_t page = first; page <= last; page++){
+		pages.push_back(base | page);
+	}
+	return true;
+}
+
+// Turn every line of a chunk into the pages its request touches, counting
+// the requests add_request refuses as malformed
+static void parse_chunk(const ParseOptions& options, Chunk& chunk){
+	for(const char* line = chunk.begin; line < chunk.end;){
+		const char* eol = (const char*)memchr(line, '\n', chunk.end - line);
+		if(!eol) eol = chunk.end;
+		uint64_t device, offset, length;
+		if(parse_line(options.format, line, eol, device, offset, length)){
+			if(options.one_device && device != options.device) chunk.other_devices++;
+			else if(!add_request(options, device, offset, length, chunk.pages)) chunk.skipped++;
+		} else if(eol > line && !(eol - line == 1 && *line == '\r')){
+			chunk.skipped++;
+		}
+		line = eol + 1;
+	}
+}
+
+// First byte after the line containing p
+static const char* next_line(const char* p, const char* end){
+	const char* eol = (const char*)memchr(p, '\n', end - p);
+	return eol ? eol + 1 : end;
+}
+
+static void usage(const char* name){
+	fprintf(stderr, "usage: %s msr|spc|arc INPUT OUTPUT [--page-size BYTES] [--width 4|8] [--varint] [--dense] [--device N] [--threads N]\n", name);
+	fprintf(stderr, "  --width 4|8   bytes per page id (default 8); ids must fit unless --dense\n");
+	fprintf(stderr, "Requests of more than %d pages, or reaching the largest 64-bit page id, are skipped.\n", MAX_REQUEST_PAGES);
+	fprintf(stderr, "  --dense       rename pages 0..K-1 in order of first use\n");
+	fprintf(stderr, "  --device N    keep only the requests of device N, instead of folding\n");
+	fprintf(stderr, "                the device number into bits %d and up of every page id\n", DEVICE_SHIFT);
+}
+
+int main(int argc, char** argv){
+	if(argc < 4){
+		usage(argv[0]);
+		return 1;
+	}
+	ParseOptions options = {FORMAT_MSR, DEFAULT_PAGE_SIZE, false, 0};
+	if(strcmp(argv[1], "msr") == 0) options.format = FORMAT_MSR;
+	else if(strcmp(argv[1], "spc") == 0) options.format = FORMAT_SPC;
+	else if(strcmp(argv[1], "arc") == 0) options.format = FORMAT_ARC;
+	else {
+		usage(argv[0]);
+		return 1;
+	}
+	unsigned int width = 8;
+	TraceEncoding encoding = TRACE_RAW;
+	unsigned int threads = 0;
+	bool dense = false;
+	for(int i = 4; i < argc; i++){
+		string option = argv[i];
+		if(option == "--varint") encoding = TRACE_DELTA_VARINT;
+		else if(option == "--dense") dense = true;
+		else if(option == "--page-size" && i + 1 < argc) options.page_size = strtoull(argv[++i], NULL, 10);
+		else if(option == "--width" && i + 1 < argc) width = strtoul(argv[++i], NULL, 10);
+		else if(option == "--device" && i + 1 < argc){
+			options.one_device = true;
+			options.device = strtoull(argv[++i], NULL, 10);
+		}
+		else if(option == "--threads" && i + 1 < argc) threads = strtoul(argv[++i], NULL, 10);
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if(options.page_size == 0){
+		fprintf(stderr, "%s: page size must be positive\n", argv[0]);
+		return 1;
+	}
+	if(width != 4 && width != 8){
+		fprintf(stderr, "%s: page id width must be 4 or 8 bytes\n", argv[0]);
+		return 1;
+	}
+
+	int fd = open(argv[2], O_RDONLY);
+	struct stat info;
+	if(fd < 0 || fstat(fd, &info) != 0){
+		perror(argv[2]);
+		return 1;
+	}
+	const size_t size = info.st_size;
+	const char* input = size > 0 ? (const char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+	close(fd);
+	if(input == MAP_FAILED){
+		perror(argv[2]);
+		return 1;
+	}
+	if(size > 0) madvise((void*)input, size, MADV_SEQUENTIAL);
+
+	TraceWriter writer;
+	if(!writer.open(argv[3], width, encoding)){
+		perror(argv[3]);
+		return 1;
+	}
+
+	// Parse the input a window at a time so memory stays bounded, with each
+	// window split at line boundaries into one chunk per thread
+	TaskPool pool(threads);
+	vector<Chunk> chunks(pool.size());
+	// With --dense, pages are renamed 0..K-1 in order of first use as they are written
+	PageRemapper remapper;
+	uint64_t accesses = 0, skipped = 0, other_devices = 0;
+	const char* end = input + size;
+	for(const char* window = input; window < end;){
+		const char* window_end = next_line(window + std::min<size_t>(WINDOW_BYTES, end - window) - 1, end);
+		const size_t share = (window_end - window) / chunks.size() + 1;
+		const char* begin = window;
+		for(Chunk& chunk : chunks){
+			chunk.begin = begin;
+			chunk.end = begin < window_end ? next_line(std::min(begin + share, window_end) - 1, window_end) : window_end;
+			chunk.pages.clear();
+			chunk.skipped = 0;
+			chunk.other_devices = 0;
+			begin = chunk.end;
+			pool.submit([&chunk, &options](){ parse_chunk(options, chunk); });
+		}
+		pool.wait();
+		for(Chunk& chunk : chunks){
+			if(dense){
+				for(uint64_t& page : chunk.pages) page = remapper.map(page);
+			}
+			else if(width == 4){
+				for(uint64_t page : chunk.pages){
+					// UINT32_MAX is reserved by the 32-bit engines
+					if(page >= UINT32_MAX){
+						fprintf(stderr, "%s: page id %llu does not fit in 4 bytes, use --dense or --width 8\n", argv[0], (unsigned long long)page);
+						writer.close();
+						unlink(argv[3]);
+						return 1;
+					}
+				}
+			}
+			if(!writer.write(chunk.pages.data(), chunk.pages.size())){
+				perror(argv[3]);
+				writer.close();
+				unlink(argv[3]);
+				return 1;
+			}
+			accesses += chunk.pages.size();
+			skipped += chunk.skipped;
+			other_devices += chunk.other_devices;
+		}
+		window = window_end;
+	}
+	if(size > 0) munmap((void*)input, size);
+	if(!writer.close()){
+		perror(argv[3]);
+		unlink(argv[3]);
+		return 1;
+	}
+	fprintf(stderr, "%llu page accesses written, %llu lines skipped\n", (unsigned long long)accesses, (unsigned long long)skipped);
+	if(options.one_device) fprintf(stderr, "%llu requests of other devices dropped\n", (unsigned long long)other_devices);
+	if(dense) fprintf(stderr, "%u distinct pages\n", remapper.size());
+	return 0;
+}
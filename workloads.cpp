@@ -1,37 +1,188 @@
 #include <stdlib.h>
 #include <vector>
-#include <random>
+#include <algorithm>
+#include <cmath>
 #include "workloads.hpp"
+#include "policies.hpp"
 
+// Accesses pulled from a stream at a time when simulating it
+static const size_t STREAM_CHUNK = 4096;
 
-using std::default_random_engine;
-void workload_nonlocal(vector<int>& workload, int num_pages){
-	default_random_engine random_engine;
-	random_engine.seed(std::time(NULL));
-	std::uniform_int_distribution<int> gen(0 , num_pages - 1);
-	for(int& i : workload){ //We get to use convient syntax and still modify the array
-		i = gen(random_engine);
+// Uniform integer in [0, bound), drawn the same way for bounds below 2^32 so
+// that small page spaces give the same workload at either page id width
+static uint64_t draw_below(Xoshiro256& random_engine, uint64_t bound){
+	if(bound <= UINT32_MAX) return random_engine.below(bound);
+	return random_engine.below64(bound);
+}
+
+template <typename PageId>
+NonlocalStream<PageId>::NonlocalStream(uint64_t length, uint64_t num_pages, uint64_t seed)
+	: remaining(length), num_pages(num_pages), random_engine(seed){
+}
+
+template <typename PageId>
+size_t NonlocalStream<PageId>::next(PageId* out, size_t n){
+	n = std::min<uint64_t>(n, remaining);
+	for(size_t i = 0; i < n; i++){
+		out[i] = draw_below(random_engine, num_pages);
 	}
+	remaining -= n;
+	return n;
+}
+
+template <typename PageId>
+EightyTwentyStream<PageId>::EightyTwentyStream(uint64_t length, uint64_t num_pages, uint64_t seed)
+	: remaining(length), num_hot((2 * num_pages) / 5), num_cold(num_pages - (2 * num_pages) / 5 + 1), random_engine(seed){
 }
-void workload_80_20(vector<int>& workload, int num_pages){
-	default_random_engine random_engine;
-	random_engine.seed(std::time(NULL));
-	std::uniform_int_distribution<int> eighty(1 , 5); //if 1 or 2, use cold page. Otherwise, use a hot page
-	std::uniform_int_distribution<int> hot_pages(0,  (2 * num_pages) / 5 - 1);
-	std::uniform_int_distribution<int> cold_pages(2 * num_pages / 5, num_pages );
-	for(int& i : workload){ //We get to use convient syntax and still modify the array
-		if(eighty(random_engine) <= 2) i = cold_pages(random_engine);
-		else i = hot_pages(random_engine);
+
+template <typename PageId>
+size_t EightyTwentyStream<PageId>::next(PageId* out, size_t n){
+	n = std::min<uint64_t>(n, remaining);
+	for(size_t i = 0; i < n; i++){
+		//2 in 5 accesses use a cold page. Otherwise, use a hot page
+		if(random_engine.below(5) < 2) out[i] = num_hot + draw_below(random_engine, num_cold);
+		else out[i] = draw_below(random_engine, num_hot);
 	}
+	remaining -= n;
+	return n;
 }
 
-void workload_looping(vector<int>& workload, int num_pages){
-	int page = 0;
-	for(int& i : workload){
-		i = page;
+template <typename PageId>
+LoopingStream<PageId>::LoopingStream(uint64_t length, uint64_t num_pages, uint64_t seed)
+	: remaining(length), loop_length(num_pages / 2), page(0){
+}
+
+template <typename PageId>
+size_t LoopingStream<PageId>::next(PageId* out, size_t n){
+	n = std::min<uint64_t>(n, remaining);
+	for(size_t i = 0; i < n; i++){
+		out[i] = page;
 		page++;
-		page %= num_pages / 2;
+		if(page >= loop_length) page = 0;
+	}
+	remaining -= n;
+	return n;
+}
+
+// log1p(x) / x, accurate near 0
+static double helper1(double x){
+	if(std::fabs(x) > 1e-8) return std::log1p(x) / x;
+	return 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+}
+
+// expm1(x) / x, accurate near 0
+static double helper2(double x){
+	if(std::fabs(x) > 1e-8) return std::expm1(x) / x;
+	return 1 + x * 0.5 * (1 + x * (1.0 / 3) * (1 + 0.25 * x));
+}
+
+template <typename PageId>
+ZipfStream<PageId>::ZipfStream(uint64_t length, uint64_t num_pages, double skew, uint64_t seed)
+	: remaining(length), num_pages(num_pages), skew(skew), random_engine(seed){
+	h_integral_x1 = h_integral(1.5) - 1;
+	h_integral_num_pages = h_integral(num_pages + 0.5);
+	s = 2 - h_integral_inverse(h_integral(2.5) - h(2));
+}
+
+template <typename PageId>
+size_t ZipfStream<PageId>::next(PageId* out, size_t n){
+	n = std::min<uint64_t>(n, remaining);
+	for(size_t i = 0; i < n; i++){
+		out[i] = sample();
+	}
+	remaining -= n;
+	return n;
+}
+
+/*
+ * Ranks 1..num_pages are drawn by inverting the integral H of the hat
+ * function h(x) = x^-skew, then accepting rank k when x falls in the part of
+ * [k - 0.5, k + 0.5] under the histogram of the true distribution. Most draws
+ * are accepted by the cheap k - x <= s test.
+ */
+template <typename PageId>
+PageId ZipfStream<PageId>::sample(){
+	for(;;){
+		double u = h_integral_num_pages + random_engine.uniform() * (h_integral_x1 - h_integral_num_pages);
+		double x = h_integral_inverse(u);
+		double rounded = x + 0.5;
+		if(rounded < 1) rounded = 1;
+		else if(rounded > num_pages) rounded = num_pages;
+		uint64_t k = (uint64_t)rounded;
+		if(k - x <= s || u >= h_integral(k + 0.5) - h(k)){
+			return k - 1;
+		}
+	}
+}
+
+template <typename PageId>
+double ZipfStream<PageId>::h(double x) const{
+	return std::exp(-skew * std::log(x));
+}
+
+template <typename PageId>
+double ZipfStream<PageId>::h_integral(double x) const{
+	double log_x = std::log(x);
+	return helper2((1 - skew) * log_x) * log_x;
+}
+
+template <typename PageId>
+double ZipfStream<PageId>::h_integral_inverse(double x) const{
+	double t = x * (1 - skew);
+	if(t < -1) t = -1;
+	return std::exp(helper1(t) * x);
+}
+
+template <typename PageId>
+uint64_t simulate_stream(WorkloadStream<PageId>& stream, Policy<PageId>& policy){
+	PageId chunk[STREAM_CHUNK];
+	uint64_t hits = 0;
+	for(size_t n = stream.next(chunk, STREAM_CHUNK); n > 0; n = stream.next(chunk, STREAM_CHUNK)){
+		hits += policy.access_batch(chunk, n, NULL);
 	}
+	return hits;
+}
+
+template <typename PageId>
+void workload_nonlocal(vector<PageId>& workload, uint64_t num_pages, uint64_t seed){
+	NonlocalStream<PageId> stream(workload.size(), num_pages, seed);
+	stream.next(workload.data(), workload.size());
+}
+
+template <typename PageId>
+void workload_80_20(vector<PageId>& workload, uint64_t num_pages, uint64_t seed){
+	EightyTwentyStream<PageId> stream(workload.size(), num_pages, seed);
+	stream.next(workload.data(), workload.size());
+}
+
+template <typename PageId>
+void workload_looping(vector<PageId>& workload, uint64_t num_pages, uint64_t seed){
+	LoopingStream<PageId> stream(workload.size(), num_pages, seed);
+	stream.next(workload.data(), workload.size());
+}
+
+template <typename PageId>
+void workload_zipf(vector<PageId>& workload, uint64_t num_pages, uint64_t seed){
+	workload_zipf_skewed(workload, num_pages, ZIPF_DEFAULT_SKEW, seed);
+}
+
+template <typename PageId>
+void workload_zipf_skewed(vector<PageId>& workload, uint64_t num_pages, double skew, uint64_t seed){
+	ZipfStream<PageId> stream(workload.size(), num_pages, skew, seed);
+	stream.next(workload.data(), workload.size());
 }
 
+#define INSTANTIATE_WORKLOADS(PageId) \
+	template class NonlocalStream<PageId>; \
+	template class EightyTwentyStream<PageId>; \
+	template class LoopingStream<PageId>; \
+	template class ZipfStream<PageId>; \
+	template uint64_t simulate_stream(WorkloadStream<PageId>&, Policy<PageId>&); \
+	template void workload_nonlocal(vector<PageId>&, uint64_t, uint64_t); \
+	template void workload_80_20(vector<PageId>&, uint64_t, uint64_t); \
+	template void workload_looping(vector<PageId>&, uint64_t, uint64_t); \
+	template void workload_zipf(vector<PageId>&, uint64_t, uint64_t); \
+	template void workload_zipf_skewed(vector<PageId>&, uint64_t, double, uint64_t);
 
+INSTANTIATE_WORKLOADS(uint32_t)
+INSTANTIATE_WORKLOADS(uint64_t)
@@ -3,32 +3,168 @@
 #include <stdlib.h>
 #include <random>
 #include <ctime>
+#include <cstdint>
+#include "rng.hpp"
 
 using std::vector;
-typedef void (*Workload)(vector<int>&, int );
+// Workload generator function pointer type, the same seed always gives the same workload.
+// Generators are instantiated for uint32_t and uint64_t page ids.
+template <typename PageId>
+using Workload = void (*)(vector<PageId>&, uint64_t, uint64_t);
+
+// Version of what the generators produce. Bump it whenever a seed stops giving
+// the same workload as before, so that saved traces of older builds are not reused.
+static const unsigned int WORKLOAD_VERSION = 1;
+
+template <typename PageId>
+class Policy;
+
+/*\brief Pull-based source of page accesses that never holds the whole trace
+ *
+ * Streams yield their accesses in chunks, so traces far larger than memory
+ * can be simulated in constant space. A stream gives the same accesses as the
+ * matching vector generator for the same seed.
+ */
+template <typename PageId>
+class WorkloadStream {
+public:
+	virtual ~WorkloadStream() {}
+
+	/*\brief Produce the next accesses of the stream
+	 *
+	 * param out where to write the accesses
+	 * param n maximum number of accesses to write
+	 * return number of accesses written, 0 once the stream is exhausted
+	 */
+	virtual size_t next(PageId* out, size_t n) = 0;
+};
+
+// Uniformly random pages, see workload_nonlocal
+template <typename PageId>
+class NonlocalStream : public WorkloadStream<PageId> {
+public:
+	NonlocalStream(uint64_t length, uint64_t num_pages, uint64_t seed);
+	size_t next(PageId* out, size_t n) override;
+private:
+	uint64_t remaining;
+	uint64_t num_pages;
+	Xoshiro256 random_engine;
+};
+
+// Hot and cold pages, see workload_80_20
+template <typename PageId>
+class EightyTwentyStream : public WorkloadStream<PageId> {
+public:
+	EightyTwentyStream(uint64_t length, uint64_t num_pages, uint64_t seed);
+	size_t next(PageId* out, size_t n) override;
+private:
+	uint64_t remaining;
+	uint64_t num_hot;
+	uint64_t num_cold;
+	Xoshiro256 random_engine;
+};
+
+// A loop over half the pages, see workload_looping
+template <typename PageId>
+class LoopingStream : public WorkloadStream<PageId> {
+public:
+	LoopingStream(uint64_t length, uint64_t num_pages, uint64_t seed);
+	size_t next(PageId* out, size_t n) override;
+private:
+	uint64_t remaining;
+	uint64_t loop_length;
+	uint64_t page;
+};
+
+/*\brief Zipf distributed pages, page k drawn with probability proportional to 1/(k+1)^skew
+ *
+ * Uses the rejection-inversion method of Hormann and Derflinger, which costs
+ * O(1) per sample (about one uniform draw on average) and needs no table over
+ * the page space, so huge page spaces cost nothing to set up.
+ */
+template <typename PageId>
+class ZipfStream : public WorkloadStream<PageId> {
+public:
+	ZipfStream(uint64_t length, uint64_t num_pages, double skew, uint64_t seed);
+	size_t next(PageId* out, size_t n) override;
+	// Draw a single page
+	PageId sample();
+private:
+	double h(double x) const;
+	double h_integral(double x) const;
+	double h_integral_inverse(double x) const;
+
+	uint64_t remaining;
+	uint64_t num_pages;
+	double skew;
+	double h_integral_x1;
+	double h_integral_num_pages;
+	double s;
+	Xoshiro256 random_engine;
+};
+
+/*\brief Feeds a whole stream to a policy, one chunk at a time
+ *
+ * param stream the accesses to simulate
+ * param policy the policy receiving them
+ * return number of hits during the stream
+ */
+template <typename PageId>
+uint64_t simulate_stream(WorkloadStream<PageId>& stream, Policy<PageId>& policy);
 
 /*\brief Simulates a page workload that does not exhibit locality,
  * which here is accomplished with generating random page numbers
  *
- * param vector<int>& workload the vector to fill with the workload, which 
+ * param vector<PageId>& workload the vector to fill with the workload, which 
  * should already be of the proper size
  * param num_pages the number of addressable pages
+ * param seed seed for the random page numbers
  */
-void workload_nonlocal(vector<int>& workload, int num_pages);
+template <typename PageId>
+void workload_nonlocal(vector<PageId>& workload, uint64_t num_pages, uint64_t seed);
 
 /*\brief Simulates a page workload following the 80-20 rule
  * which here will simply be pages 0 - 20 getting 80% of the accesses
  * 
- * param vector<int>& workload the vector to fill with the workload, which 
+ * param vector<PageId>& workload the vector to fill with the workload, which 
  * should already be of the proper size
  * param num_pages the number of addressable pages
+ * param seed seed for the random page numbers
  */
-void workload_80_20(vector<int>& workload,int num_pages);
+template <typename PageId>
+void workload_80_20(vector<PageId>& workload, uint64_t num_pages, uint64_t seed);
 
 /*\brief Simulates a page workload that repeats 0,1,2,...,50 twice
  * 
- * param vector<int>& workload the vector to fill with the workload, which 
+ * param vector<PageId>& workload the vector to fill with the workload, which 
+ * should already be of the proper size
+ * param num_pages the number of addressable pages
+ * param seed unused, the loop is deterministic
+ */
+template <typename PageId>
+void workload_looping(vector<PageId>& workload, uint64_t num_pages, uint64_t seed);
+
+// Skew used by workload_zipf, close to what real page popularity shows
+#define ZIPF_DEFAULT_SKEW 1.0
+
+/*\brief Simulates a page workload with Zipf distributed page popularity,
+ * with the default skew of ZIPF_DEFAULT_SKEW
+ *
+ * param vector<PageId>& workload the vector to fill with the workload, which 
+ * should already be of the proper size
+ * param num_pages the number of addressable pages
+ * param seed seed for the random page numbers
+ */
+template <typename PageId>
+void workload_zipf(vector<PageId>& workload, uint64_t num_pages, uint64_t seed);
+
+/*\brief Simulates a page workload with Zipf distributed page popularity
+ *
+ * param vector<PageId>& workload the vector to fill with the workload, which 
  * should already be of the proper size
  * param num_pages the number of addressable pages
+ * param skew the Zipf exponent, larger is more skewed and 0 is uniform
+ * param seed seed for the random page numbers
  */
-void workload_looping(vector<int>& workload, int num_pages);
+template <typename PageId>
+void workload_zipf_skewed(vector<PageId>& workload, uint64_t num_pages, double skew, uint64_t seed);